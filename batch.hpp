@@ -0,0 +1,139 @@
+#ifndef JOB_SHOP_BATCH
+#define JOB_SHOP_BATCH
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "dataset.hpp"
+#include "instrumentation.hpp"
+#include "output.hpp"
+#include "platform.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+#include "timer.hpp"
+#include "validator.hpp"
+
+namespace js {
+
+    /**
+     * Lists the instances of a batch: the regular files of a directory, or the paths listed one per line in a
+     * manifest file (relative paths are resolved against the manifest's directory).
+     */
+    std::vector<std::string> list_instances(const std::string& path) {
+        std::vector<std::string> instances;
+        if (std::filesystem::is_directory(path)) {
+            for (const auto& entry : std::filesystem::directory_iterator(path))
+                if (entry.is_regular_file()) instances.push_back(entry.path().string());
+        } else {
+            std::ifstream manifest(path);
+            if (not manifest.is_open()) throw std::runtime_error("Could not open file " + path);
+            const std::filesystem::path base = std::filesystem::path(path).parent_path();
+            for (std::string line; std::getline(manifest, line);) {
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (line.empty() or line.front() == '#') continue;
+                const std::filesystem::path instance = line;
+                instances.push_back((instance.is_absolute() ? instance : base / instance).string());
+            }
+        }
+        return instances;
+    }
+
+    struct batch_result {
+        std::string input, error, verification;
+        size_t jobs_count = 0, machines_count = 0;
+        time32_t makespan = 0, lower_bound = 0;
+        double gap = 0;
+        uint64_t time_us = 0;
+        bool optimal = false, skipped = false;
+    };
+
+    /**
+     * Solves every instance on the pool, largest files first. Each result is written to
+     * <code>output_directory</code> (if not empty) and reported as a table row as soon as it is solved, optionally
+     * after checking it with the validator. In exact mode the row also tells whether the makespan is proven optimal.
+     * Once a stop is requested, the instances not started yet are skipped and reported as such.
+     */
+    std::vector<batch_result> solve_batch(std::vector<std::string> inputs, const solver_options& options,
+                                          const std::string& output_directory, thread_pool& pool,
+                                          std::ostream& report, bool verify = false) {
+        std::vector<std::pair<uintmax_t, std::string>> by_size;
+        for (auto& input : inputs) by_size.emplace_back(std::filesystem::file_size(input), std::move(input));
+        std::stable_sort(by_size.begin(), by_size.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < inputs.size(); i++) inputs[i] = std::move(by_size[i].second);
+        if (not output_directory.empty()) std::filesystem::create_directories(output_directory);
+
+        std::vector<batch_result> results(inputs.size());
+        std::mutex report_mutex;
+        report << std::left << std::setw(24) << "instance" << std::right << std::setw(8) << "jobs"
+               << std::setw(10) << "machines" << std::setw(12) << "makespan" << std::setw(10) << "bound"
+               << std::setw(10) << "gap [%]" << std::setw(14) << "time [us]";
+        if (options.exact) report << std::setw(9) << "optimal";
+        if (verify) report << "  check";
+        report << std::endl;
+
+        for (size_t i = 0; i < inputs.size(); i++) {
+            pool.submit([&, i] {
+                batch_result& result = results[i];
+                result.input = inputs[i];
+                result.skipped = options.stop != nullptr and options.stop->load(std::memory_order_relaxed);
+                if (not result.skipped) try {
+                    timer<precision::us> clock;
+                    clock.start();
+                    instance data;
+                    {
+                        JS_SCOPE("parse");
+                        data.load_from_file(inputs[i], options.limit);
+                    }
+                    thread_pool inline_pool(0);
+                    solver_options instance_options = options;
+                    instance_options.instance = extract_file_name(inputs[i]);
+                    solver solver(data, instance_options);
+                    const schedule& solution = solver.solve(inline_pool);
+                    if (not output_directory.empty()) {
+                        JS_SCOPE("output");
+                        std::ofstream output(output_directory + path_sep + extract_file_name(inputs[i]));
+                        output_sink sink(output);
+                        solution.write_summary(sink);
+                    }
+                    clock.stop();
+                    result.jobs_count = data.jobs_count;
+                    result.machines_count = data.machines_count;
+                    result.makespan = solution.longest_timeline();
+                    result.lower_bound = solver.lower_bound().value();
+                    result.gap = solver.lower_bound().gap(result.makespan);
+                    result.time_us = clock.get_measured_time();
+                    result.optimal = solver.proven_optimal();
+                    if (verify) {
+                        const validation validation = validate(solution);
+                        result.verification = validation ? "OK" : validation.error;
+                    }
+                } catch (const std::exception& exception) {
+                    result.error = exception.what();
+                }
+                std::lock_guard lock(report_mutex);
+                report << std::left << std::setw(24) << extract_file_name(result.input) << std::right;
+                if (result.skipped) report << "  skipped" << std::endl;
+                else if (result.error.empty())
+                    report << std::setw(8) << result.jobs_count << std::setw(10) << result.machines_count
+                           << std::setw(12) << result.makespan << std::setw(10) << result.lower_bound
+                           << std::setw(10) << std::fixed << std::setprecision(2) << result.gap
+                           << std::setw(14) << result.time_us
+                           << (options.exact ? (result.optimal ? "      yes" : "       no") : "")
+                           << (verify ? "  " + result.verification : "") << std::endl;
+                else report << "  error: " << result.error << std::endl;
+            });
+        }
+        pool.wait();
+        return results;
+    }
+}
+
+#endif //JOB_SHOP_BATCH
@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "dataset.hpp"
+#include "engines.hpp"
+#include "generator.hpp"
+#include "incremental.hpp"
+#include "platform.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+#include "schedule.hpp"
+#include "timer.hpp"
+
+/** Heap allocations made by the whole program, counted by the replaced global allocation functions. */
+std::atomic<uint64_t> allocations = 0;
+
+/**
+ * Every replaced operator new and delete goes through these two functions. They are kept out of line, so the
+ * compiler does not pair an inlined operator new with std::free and warn about a mismatched deallocation.
+ */
+[[gnu::noinline]] void* allocate(size_t size, size_t alignment) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size = std::max<size_t>(size, 1);
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return std::malloc(size);
+#ifdef WINDOZE
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+[[gnu::noinline]] void release(void* memory, [[maybe_unused]] size_t alignment) noexcept {
+#ifdef WINDOZE
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return _aligned_free(memory);
+#endif
+    std::free(memory);
+}
+
+void* allocate_or_throw(size_t size, size_t alignment) {
+    if (void* memory = allocate(size, alignment)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return allocate_or_throw(size, 0); }
+void* operator new[](size_t size) { return allocate_or_throw(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate_or_throw(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate_or_throw(size, size_t(alignment)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, size_t(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, size_t(alignment));
+}
+
+void operator delete(void* memory) noexcept { release(memory, 0); }
+void operator delete[](void* memory) noexcept { release(memory, 0); }
+void operator delete(void* memory, size_t) noexcept { release(memory, 0); }
+void operator delete[](void* memory, size_t) noexcept { release(memory, 0); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { release(memory, 0); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { release(memory, 0); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { release(memory, size_t(alignment)); }
+void operator delete[](void* memory, std::align_val_t alignment) noexcept { release(memory, size_t(alignment)); }
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept {
+    release(memory, size_t(alignment));
+}
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept {
+    release(memory, size_t(alignment));
+}
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    release(memory, size_t(alignment));
+}
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    release(memory, size_t(alignment));
+}
+
+struct measurement {
+    std::string stage, instance;
+    size_t operations = 0, repetitions = 0;
+    double median_us = 0, p99_us = 0, allocations_per_run = 0;
+    bool steady_state = true;
+
+    /** Stages that reuse their buffers must not allocate once warmed up. */
+    [[nodiscard]] bool allocates_in_steady_state() const {
+        return steady_state and allocations_per_run > 0;
+    }
+
+    [[nodiscard]] double operations_per_second() const {
+        return median_us > 0 ? double(operations) * 1e6 / median_us : 0;
+    }
+};
+
+struct bench_options {
+    size_t warmup = 3, repetitions = 25;
+    double budget_us = 2e6;
+};
+
+volatile size_t sink;
+
+template<typename Stage>
+measurement measure(const std::string& stage, const std::string& instance, size_t operations,
+                    const bench_options& options, Stage&& run) {
+    for (size_t i = 0; i < options.warmup; i++) run();
+    std::vector<double> samples;
+    samples.reserve(options.repetitions);
+    double total = 0;
+    const uint64_t allocations_before = allocations.load();
+    while (samples.size() < options.repetitions and (samples.size() < 3 or total < options.budget_us)) {
+        js::timer<js::precision::ns> timer;
+        timer.start();
+        run();
+        timer.stop();
+        samples.push_back(double(timer.get_measured_time()) / 1000);
+        total += samples.back();
+    }
+    const double allocations_per_run = double(allocations.load() - allocations_before) / double(samples.size());
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, size_t(p * samples.size()))]; };
+    return {stage, instance, operations, samples.size(), percentile(0.5), percentile(0.99), allocations_per_run};
+}
+
+void bench_instance(const std::string& name, const std::string& text, const bench_options& options,
+                    std::vector<measurement>& results) {
+    js::instance data;
+    data.load_from_memory(text);
+    const size_t tasks = data.tasks_count();
+
+    results.push_back(measure("load_from_memory", name, tasks, options, [&] {
+        js::instance parsed;
+        parsed.load_from_memory(text);
+        sink = parsed.durations.size();
+    }));
+    results.back().steady_state = false;
+
+    js::schedule schedule(data);
+    for (const auto& entry : js::engine_registry()) {
+        const auto engine = entry.create(data);
+        results.push_back(measure(std::string("schedule/") + entry.name, name, tasks, options, [&] {
+            engine->run(schedule);
+            sink = schedule.longest_timeline();
+        }));
+    }
+
+    js::thread_pool inline_pool(0);
+    const js::solver_options portfolio_options;
+    js::solver solver(data, portfolio_options);
+    results.push_back(measure("solve/portfolio", name, tasks, options, [&] {
+        sink = solver.solve(inline_pool).longest_timeline();
+    }));
+
+    js::grasp grasp(data);
+    results.push_back(measure("grasp/100", name, 100 * tasks, options, [&] {
+        sink = grasp.run(inline_pool, 100, 0);
+    }));
+
+    js::create_engine("pass", data)->run(schedule);
+    results.push_back(measure("summary", name, tasks, options, [&] { sink = schedule.summary().size(); }));
+    results.back().steady_state = false;
+    results.push_back(measure("gantt_chart", name, tasks, options, [&] { sink = schedule.gantt_chart().size(); }));
+    results.back().steady_state = false;
+
+    js::incremental_schedule what_if(schedule);
+    size_t changed_task = 0;
+    results.push_back(measure("what_if/change_duration", name, 2, options, [&] {
+        const size_t job = changed_task % data.jobs_count, operation = changed_task++ % data.machines_count;
+        sink = what_if.change_duration(job, operation, data.duration(job, operation) + 10).makespan;
+        sink = what_if.change_duration(job, operation, data.duration(job, operation)).makespan;
+    }));
+}
+
+void write_json(std::ostream& output, const std::vector<measurement>& results) {
+    output << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const measurement& m = results[i];
+        output << std::fixed << std::setprecision(3) << "  {\"stage\": \"" << m.stage << "\", \"instance\": \""
+               << m.instance << "\", \"operations\": " << m.operations << ", \"repetitions\": " << m.repetitions
+               << ", \"median_us\": " << m.median_us << ", \"p99_us\": " << m.p99_us << ", \"ops_per_second\": "
+               << m.operations_per_second() << ", \"allocations_per_run\": " << m.allocations_per_run << "}"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    output << "]\n";
+}
+
+struct scaling_point {
+    std::string subject;
+    size_t jobs = 0, machines = 0;
+    double time_us = 0;
+    uint64_t peak_rss = 0;
+};
+
+/**
+ * One point of the scaling benchmark, run in a process of its own so that peak RSS values do not mix: loads the
+ * instance, runs the subject once and prints its time in microseconds and the peak RSS in bytes. Subjects are the
+ * engines, <code>load</code> (the loading itself) and <code>gantt_chart</code> (about a thousand columns of the
+ * chart of a pass schedule).
+ */
+void run_scaling_point(const std::string& subject, const std::string& path) {
+    js::timer<js::precision::us> timer;
+    timer.start();
+    js::instance data;
+    data.load_from_file(path);
+    timer.stop();
+    if (subject != "load") {
+        js::schedule schedule(data);
+        if (subject == "gantt_chart") {
+            js::create_engine("pass", data)->run(schedule);
+            timer.start();
+            sink = schedule.gantt_chart(std::max<js::time32_t>(schedule.longest_timeline() / 1000, 1)).size();
+            timer.stop();
+        } else {
+            const auto engine = js::create_engine(subject, data);
+            timer.start();
+            engine->run(schedule);
+            timer.stop();
+            sink = schedule.longest_timeline();
+        }
+    }
+    std::cout << std::fixed << timer.get_measured_time() << ' ' << js::peak_rss_bytes() << std::endl;
+}
+
+/**
+ * Generates instances of 1000, 3000, 10000, ... jobs up to <code>max_jobs</code> and measures every subject on each
+ * by running this executable again with <code>--scaling-point</code>. Sizes grow at most 3.3 times, so a subject of
+ * up to quadratic cost takes at most about ten times longer on the next one: once a point takes a tenth of the
+ * limit, the subject is not run on larger sizes.
+ */
+std::vector<scaling_point> run_scaling(const std::string& executable, size_t max_jobs, size_t machines,
+                                       double limit_s) {
+    std::vector<std::string> subjects = {"load"};
+    for (const auto& entry : js::engine_registry()) subjects.emplace_back(entry.name);
+    subjects.emplace_back("gantt_chart");
+    std::vector<bool> stopped(subjects.size());
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "job_shop_scaling";
+    std::filesystem::create_directories(directory);
+
+    std::vector<scaling_point> points;
+    for (size_t scale = 1000; scale <= max_jobs; scale *= 10)
+        for (const size_t jobs : {scale, 3 * scale}) {
+            if (jobs > max_jobs) break;
+            const std::string path = (directory / ("generated_" + std::to_string(jobs) + "x"
+                                                   + std::to_string(machines) + ".bin")).string();
+            {
+                std::ofstream output(path, std::ios::binary);
+                js::generate_instance(1, jobs, machines).write_binary(output);
+            }
+            for (size_t s = 0; s < subjects.size(); s++) {
+                if (stopped[s]) continue;
+                std::istringstream result(js::execute('"' + executable + "\" --scaling-point " + subjects[s] + " \""
+                                                      + path + '"'));
+                scaling_point point{subjects[s], jobs, machines};
+                if (not (result >> point.time_us >> point.peak_rss))
+                    throw std::runtime_error("Scaling point " + subjects[s] + " on " + path + " failed");
+                std::cerr << std::left << std::setw(22) << point.subject << std::right << std::setw(8) << jobs
+                          << " jobs" << std::fixed << std::setprecision(1) << std::setw(14) << point.time_us / 1000
+                          << " ms" << std::setw(10) << double(point.peak_rss) / (1 << 20) << " MB" << std::endl;
+                points.push_back(point);
+                stopped[s] = point.time_us > limit_s * 1e5;
+            }
+            std::filesystem::remove(path);
+        }
+    return points;
+}
+
+/**
+ * Growth exponents between consecutive sizes of a subject: log(ratio of values) / log(ratio of sizes), so 1 is
+ * linear and 2 quadratic.
+ */
+void write_scaling_table(std::ostream& output, const std::vector<scaling_point>& points) {
+    output << std::left << std::setw(22) << "subject" << std::right << std::setw(10) << "jobs" << std::setw(12)
+           << "tasks" << std::setw(14) << "time [ms]" << std::setw(10) << "exponent" << std::setw(12) << "peak [MB]"
+           << std::setw(10) << "exponent" << '\n';
+    for (size_t i = 0; i < points.size(); i++) {
+        const scaling_point& point = points[i];
+        const scaling_point* previous = nullptr;
+        for (size_t j = i; j-- > 0;)
+            if (points[j].subject == point.subject) {
+                previous = &points[j];
+                break;
+            }
+        const auto exponent = [&](double value, double previous_value) {
+            std::ostringstream text;
+            if (previous != nullptr and value > 0 and previous_value > 0)
+                text << std::fixed << std::setprecision(2)
+                     << std::log(value / previous_value) / std::log(double(point.jobs) / double(previous->jobs));
+            else text << "-";
+            return text.str();
+        };
+        output << std::left << std::setw(22) << point.subject << std::right << std::setw(10) << point.jobs
+               << std::setw(12) << point.jobs * point.machines << std::fixed << std::setprecision(1) << std::setw(14)
+               << point.time_us / 1000 << std::setw(10)
+               << exponent(point.time_us, previous == nullptr ? 0 : previous->time_us) << std::setw(12)
+               << double(point.peak_rss) / (1 << 20) << std::setw(10)
+               << exponent(double(point.peak_rss), previous == nullptr ? 0 : double(previous->peak_rss)) << '\n';
+    }
+}
+
+void write_scaling_json(std::ostream& output, const std::vector<scaling_point>& points) {
+    output << "[\n";
+    for (size_t i = 0; i < points.size(); i++) {
+        const scaling_point& p = points[i];
+        output << std::fixed << std::setprecision(3) << "  {\"subject\": \"" << p.subject << "\", \"jobs\": " << p.jobs
+               << ", \"machines\": " << p.machines << ", \"tasks\": " << p.jobs * p.machines << ", \"time_us\": "
+               << p.time_us << ", \"peak_rss_bytes\": " << p.peak_rss << "}" << (i + 1 < points.size() ? "," : "")
+               << "\n";
+    }
+    output << "]\n";
+}
+
+int main(int argc, char** argv) {
+
+    std::string data_directory = "testing/data", output_path;
+    std::vector<std::string> instances = {"ft06", "ft10", "la40", "swv20", "tai41", "tai71", "tai80"};
+    bench_options options;
+    size_t generated_jobs = 1000, generated_machines = 100, scaling_jobs = 0, scaling_machines = 0;
+    double scaling_limit_s = 10;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "-d") data_directory = argv[++i];
+        if (std::string(argv[i]) == "-o") output_path = argv[++i];
+        if (std::string(argv[i]) == "-r") options.repetitions = std::stoul(argv[++i]);
+        if (std::string(argv[i]) == "-w") options.warmup = std::stoul(argv[++i]);
+        if (std::string(argv[i]) == "-b") options.budget_us = std::stod(argv[++i]) * 1000;
+        if (std::string(argv[i]) == "-i") instances = {argv[++i]};
+        if (std::string(argv[i]) == "-s") {
+            generated_jobs = std::stoul(argv[++i]);
+            generated_machines = std::stoul(argv[++i]);
+        }
+        if (std::string(argv[i]) == "--scaling") {
+            scaling_jobs = std::stoul(argv[++i]);
+            scaling_machines = std::stoul(argv[++i]);
+        }
+        if (std::string(argv[i]) == "--limit") scaling_limit_s = std::stod(argv[++i]);
+        if (std::string(argv[i]) == "--scaling-point" and i + 2 < argc) {
+            run_scaling_point(argv[i + 1], argv[i + 2]);
+            return 0;
+        }
+    }
+
+    if (scaling_jobs > 0 and scaling_machines > 0) {
+        const auto points = run_scaling(argv[0], scaling_jobs, scaling_machines, scaling_limit_s);
+        write_scaling_table(std::cerr, points);
+        if (output_path.empty()) write_scaling_json(std::cout, points);
+        else {
+            std::ofstream output(output_path);
+            write_scaling_json(output, points);
+        }
+        return 0;
+    }
+
+    std::vector<measurement> results;
+    for (const auto& name : instances) {
+        const std::string path = data_directory + js::path_sep + name + ".txt";
+        if (not std::filesystem::exists(path)) {
+            std::cerr << "Skipping missing instance " << path << std::endl;
+            continue;
+        }
+        bench_instance(name, std::string(js::mapped_file(path).view()), options, results);
+    }
+    if (generated_jobs > 0 and generated_machines > 0) {
+        std::ostringstream text;
+        js::generate_instance(1, generated_jobs, generated_machines).write(text);
+        bench_instance("generated_" + std::to_string(generated_jobs) + "x" + std::to_string(generated_machines),
+                       text.str(), options, results);
+    }
+
+    for (const auto& m : results)
+        std::cerr << std::left << std::setw(28) << m.stage << std::setw(18) << m.instance << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << m.median_us << " us" << std::setw(12) << m.p99_us
+                  << " us" << std::setw(16) << std::setprecision(0) << m.operations_per_second() << " ops/s"
+                  << std::setw(12) << std::setprecision(1) << m.allocations_per_run << " allocs"
+                  << (m.allocates_in_steady_state() ? "  allocates in steady state" : "") << std::endl;
+
+    if (output_path.empty()) write_json(std::cout, results);
+    else {
+        std::ofstream output(output_path);
+        write_json(output, results);
+    }
+    const bool allocating = std::any_of(results.begin(), results.end(), [](const measurement& m) {
+        return m.allocates_in_steady_state();
+    });
+    if (allocating) std::cerr << "Some steady state stages allocate" << std::endl;
+    return allocating ? 1 : 0;
+}
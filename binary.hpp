@@ -0,0 +1,107 @@
+#ifndef JOB_SHOP_BINARY
+#define JOB_SHOP_BINARY
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace js::binary {
+
+    /*
+     * Versioned little-endian formats, laid out so that the arrays are 4-byte aligned in a memory-mapped file:
+     *
+     * instance: "JSIB" | u16 version | u16 reserved | u32 jobs | u32 machines | i32 machines[] | u32 durations[]
+     *           [ | u32 eligible_count | u32 downtimes_count | u32 eligible_offsets[jobs * machines + 1]
+     *             | i32 eligible[eligible_count] | (i32 machine, u32 start, u32 end) downtimes[downtimes_count] ]
+     * solution: "JSSB" | u16 version | u16 reserved | u32 jobs | u32 machines | u32 makespan | u32 machines_listed
+     *           | u32 start_times[] [ | i32 machines[] ]
+     *
+     * Arrays hold jobs * machines elements indexed by job * machines + operation. Version 2 adds the bracketed
+     * parts: the eligible machines and downtimes of an instance, the offsets only when some task has eligible
+     * machines, and the machine of every task of a solution to a flexible instance, when machines_listed is 1.
+     * Files without them are still written as version 1.
+     */
+
+    constexpr uint16_t version = 2;
+    constexpr std::string_view instance_magic = "JSIB", solution_magic = "JSSB";
+    constexpr size_t instance_header_size = 16, solution_header_size = 24;
+
+    inline bool has_magic(std::string_view data, std::string_view magic) {
+        return data.substr(0, magic.size()) == magic;
+    }
+
+    template<typename T>
+    T read(const char* source) {
+        std::array<unsigned char, sizeof(T)> bytes{};
+        std::memcpy(bytes.data(), source, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) std::reverse(bytes.begin(), bytes.end());
+        T value;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void write(std::ostream& output, T value) {
+        std::array<char, sizeof(T)> bytes{};
+        std::memcpy(bytes.data(), &value, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) std::reverse(bytes.begin(), bytes.end());
+        output.write(bytes.data(), sizeof(T));
+    }
+
+    template<typename T>
+    void read_array(const char* source, T* target, size_t count) {
+        if constexpr (std::endian::native == std::endian::little) std::memcpy(target, source, count * sizeof(T));
+        else for (size_t i = 0; i < count; i++) target[i] = read<T>(source + i * sizeof(T));
+    }
+
+    template<typename T>
+    void write_array(std::ostream& output, const T* source, size_t count) {
+        if constexpr (std::endian::native == std::endian::little)
+            output.write(reinterpret_cast<const char*>(source), std::streamsize(count * sizeof(T)));
+        else for (size_t i = 0; i < count; i++) write(output, source[i]);
+    }
+
+    struct header {
+        uint16_t version;
+        uint32_t jobs_count, machines_count;
+    };
+
+    inline void check_size(std::string_view data, std::string_view magic, uint64_t size) {
+        if (data.size() != size)
+            throw std::runtime_error("Binary " + std::string(magic) + " file has an unexpected size");
+    }
+
+    /**
+     * Validates the common header part and that the file holds <code>arrays_count</code> arrays after it, exactly
+     * so for version 1, and returns the header.
+     */
+    inline header read_header(std::string_view data, std::string_view magic, size_t header_size,
+                              size_t arrays_count) {
+        if (data.size() < header_size or not has_magic(data, magic))
+            throw std::runtime_error("Not a binary " + std::string(magic) + " file");
+        const auto file_version = read<uint16_t>(data.data() + 4);
+        if (file_version == 0 or file_version > version)
+            throw std::runtime_error("Unsupported binary format version " + std::to_string(file_version));
+        const auto jobs_count = read<uint32_t>(data.data() + 8), machines_count = read<uint32_t>(data.data() + 12);
+        const uint64_t size = header_size + arrays_count * 4 * uint64_t(jobs_count) * machines_count;
+        if (file_version == 1 or data.size() < size) check_size(data, magic, size);
+        return {file_version, jobs_count, machines_count};
+    }
+
+    inline void write_header(std::ostream& output, std::string_view magic, size_t jobs_count, size_t machines_count,
+                             uint16_t file_version = 1) {
+        output.write(magic.data(), std::streamsize(magic.size()));
+        write<uint16_t>(output, file_version);
+        write<uint16_t>(output, 0);
+        write<uint32_t>(output, uint32_t(jobs_count));
+        write<uint32_t>(output, uint32_t(machines_count));
+    }
+}
+
+#endif //JOB_SHOP_BINARY
@@ -0,0 +1,104 @@
+#ifndef JOB_SHOP_BOUNDS
+#define JOB_SHOP_BOUNDS
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "dataset.hpp"
+
+namespace js {
+
+    struct lower_bounds {
+
+        time32_t machine_load = 0, job_length = 0, one_machine = 0;
+
+        [[nodiscard]] time32_t value() const {
+            return std::max({machine_load, job_length, one_machine});
+        }
+
+        /** Relative distance of a makespan from the bound, in percent. */
+        [[nodiscard]] double gap(time32_t makespan) const {
+            const time32_t bound = value();
+            return bound == 0 ? 0.0 : 100.0 * (double(makespan) - double(bound)) / double(bound);
+        }
+    };
+
+    /**
+     * Makespan of Jackson's preemptive schedule of one machine: at every moment the released task with the longest
+     * tail runs, and a release may preempt it. <code>task(i)</code> gives the <code>{release, duration, tail}</code>
+     * of the i-th of <code>count</code> tasks, which must be sorted by release time. The heap of released tasks lives
+     * in the caller's <code>released</code> buffer, so repeated calls do not allocate.
+     */
+    template<typename Time, typename Task>
+    Time jackson_preemptive(size_t count, const Task& task, std::vector<std::pair<Time, Time>>& released) {
+        released.clear();
+        Time time = 0, makespan = 0;
+        for (size_t i = 0; i < count or not released.empty();) {
+            if (released.empty()) time = std::max(time, Time(task(i)[0]));
+            for (; i < count and task(i)[0] <= time; i++) {
+                released.emplace_back(task(i)[2], task(i)[1]);
+                std::push_heap(released.begin(), released.end());
+            }
+            std::pop_heap(released.begin(), released.end());
+            const auto [tail, remaining] = released.back();
+            released.pop_back();
+            const Time next_release = i < count ? Time(task(i)[0]) : std::numeric_limits<Time>::max();
+            const Time run = std::min(remaining, next_release - time);
+            time += run;
+            if (run == remaining) makespan = std::max(makespan, time + tail);
+            else {
+                released.emplace_back(tail, remaining - run);
+                std::push_heap(released.begin(), released.end());
+            }
+        }
+        return makespan;
+    }
+
+    /**
+     * Standard lower bounds on the makespan: the largest machine load, the longest job and the one-machine
+     * relaxation, which gives every task its job's head as release time and its job's tail as delivery time and
+     * solves each machine with Jackson's preemptive schedule. Downtimes only delay tasks, so the bounds still hold.
+     * In a flexible instance tasks may move between machines: the machine load is then the total work spread evenly
+     * over all machines and the one-machine relaxation does not apply.
+     */
+    lower_bounds compute_lower_bounds(const instance& data) {
+        lower_bounds bounds;
+        if (data.flexible()) {
+            const uint64_t work = std::accumulate(data.durations.begin(), data.durations.end(), uint64_t(0));
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                const auto begin = data.durations.begin() + ptrdiff_t(data.index(job, 0));
+                bounds.job_length = std::max(bounds.job_length, std::accumulate(
+                        begin, begin + ptrdiff_t(data.machines_count), time32_t(0)));
+            }
+            if (data.machines_count > 0)
+                bounds.machine_load = time32_t((work + data.machines_count - 1) / data.machines_count);
+            return bounds;
+        }
+        std::vector<std::vector<std::array<uint64_t, 3>>> machine_tasks(data.machines_count);
+        for (size_t job = 0; job < data.jobs_count; job++) {
+            const auto begin = data.durations.begin() + ptrdiff_t(data.index(job, 0));
+            const uint64_t length = std::accumulate(begin, begin + ptrdiff_t(data.machines_count), uint64_t(0));
+            uint64_t head = 0;
+            for (size_t i = 0; i < data.machines_count; i++) {
+                const uint64_t duration = data.duration(job, i);
+                machine_tasks[data.machine(job, i)].push_back({head, duration, length - head - duration});
+                head += duration;
+            }
+            bounds.job_length = std::max(bounds.job_length, time32_t(length));
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> released;
+        for (auto& tasks : machine_tasks) {
+            std::sort(tasks.begin(), tasks.end());
+            uint64_t load = 0;
+            for (const auto& task : tasks) load += task[1];
+            bounds.machine_load = std::max(bounds.machine_load, time32_t(load));
+            const uint64_t makespan = jackson_preemptive(tasks.size(), [&](size_t i) { return tasks[i]; }, released);
+            bounds.one_machine = std::max(bounds.one_machine, time32_t(makespan));
+        }
+        return bounds;
+    }
+}
+
+#endif //JOB_SHOP_BOUNDS
@@ -0,0 +1,306 @@
+#ifndef JOB_SHOP_BRANCH_AND_BOUND
+#define JOB_SHOP_BRANCH_AND_BOUND
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "bounds.hpp"
+#include "dataset.hpp"
+#include "thread_pool.hpp"
+#include "timer.hpp"
+
+namespace js {
+
+    /**
+     * Exact solver: depth-first branch and bound over the active schedules of the disjunctive graph. A node fixes a
+     * prefix of every machine sequence; it branches, as Giffler and Thompson, on the operations that conflict on the
+     * machine of the earliest completing operation, each child putting one of them next on that machine. Heads are
+     * propagated along the jobs from the job and machine ready times, tails are the remaining work of the jobs, and
+     * Jackson's preemptive schedule of every machine bounds the node, after immediate selection fixed the pairs of
+     * tasks whose order the incumbent already decides. A child is also dropped as soon as another conflicting
+     * operation could no longer finish in time behind it. The first levels are explored in parallel on the pool,
+     * each worker stealing whole subtrees.
+     */
+    class branch_and_bound {
+
+        static constexpr size_t parallel_depth = 3, check_interval = 256, selection_passes = 8;
+
+        struct child {
+            time32_t bound;
+            uint32_t job;
+        };
+
+        /** Partial schedule of a node and the scratch buffers of the thread exploring it. */
+        struct node_state {
+            std::vector<uint32_t> next_operation;
+            std::vector<time32_t> job_ready, machine_ready, starts, heads, tails;
+            std::vector<std::vector<uint32_t>> machine_tasks;
+            std::vector<std::vector<child>> children;
+            std::vector<std::pair<time32_t, time32_t>> released;
+            uint64_t nodes = 0;
+        };
+
+        const instance& data;
+        std::vector<time32_t> job_tails;
+        solution_state best;
+        std::mutex best_mutex;
+        std::atomic<time32_t> upper = 0;
+        std::atomic<uint64_t> nodes = 0;
+        std::atomic<bool> aborted = false;
+        time32_t target = 0;
+        uint64_t node_limit = 0, time_limit_us = 0;
+        const std::atomic<bool>* stop = nullptr;
+        timer<precision::us> clock;
+
+        [[nodiscard]] bool finished() const {
+            return aborted.load(std::memory_order_relaxed) or upper.load(std::memory_order_relaxed) <= target;
+        }
+
+        /** Schedules the next operation of a job at its earliest start and returns what it overwrote. */
+        std::tuple<time32_t, time32_t> apply(node_state& state, uint32_t job) const {
+            const size_t index = data.index(job, state.next_operation[job]);
+            const id32_t machine = data.machines[index];
+            const std::tuple previous(state.job_ready[job], state.machine_ready[machine]);
+            const time32_t start = std::max(state.job_ready[job], state.machine_ready[machine]);
+            state.starts[index] = start;
+            state.job_ready[job] = state.machine_ready[machine] = start + data.durations[index];
+            state.next_operation[job]++;
+            return previous;
+        }
+
+        void undo(node_state& state, uint32_t job, const std::tuple<time32_t, time32_t>& previous) const {
+            const size_t index = data.index(job, --state.next_operation[job]);
+            std::tie(state.job_ready[job], state.machine_ready[data.machines[index]]) = previous;
+        }
+
+        /** Makespan of Jackson's preemptive schedule of one machine, its tasks sorted by head. */
+        time32_t preemptive_makespan(node_state& state, const std::vector<uint32_t>& tasks) const {
+            return jackson_preemptive(tasks.size(), [&](size_t i) {
+                return std::array{state.heads[tasks[i]], data.durations[tasks[i]], state.tails[tasks[i]]};
+            }, state.released);
+        }
+
+        /**
+         * Lifts heads and tails by immediate selection until they settle: when task <code>j</code> cannot precede
+         * task <code>i</code> of the same machine in a schedule shorter than the incumbent, <code>i</code> precedes
+         * <code>j</code>, which raises the head of <code>j</code> and the tail of <code>i</code>. Likewise a task that
+         * cannot come first (last) among the tasks of its machine starts after the earliest other one ends (ends
+         * before the latest other one starts). Both are then propagated along the jobs. Returns false when some task
+         * cannot finish before the incumbent.
+         */
+        bool select(node_state& state, time32_t limit) const {
+            auto& heads = state.heads;
+            auto& tails = state.tails;
+            for (size_t pass = 0, changed = 1; pass < selection_passes and changed; pass++) {
+                changed = 0;
+                for (const auto& tasks : state.machine_tasks) {
+                    time32_t total = 0;
+                    for (const uint32_t i : tasks) total += data.durations[i];
+                    for (const uint32_t i : tasks) {
+                        time32_t other_head = limit, other_tail = limit, other_end = limit, other_delivery = limit;
+                        for (const uint32_t j : tasks) {
+                            if (i == j) continue;
+                            other_head = std::min(other_head, heads[j]);
+                            other_tail = std::min(other_tail, tails[j]);
+                            other_end = std::min(other_end, heads[j] + data.durations[j]);
+                            other_delivery = std::min(other_delivery, data.durations[j] + tails[j]);
+                            const time32_t before = heads[i] + data.durations[i], after = data.durations[j] + tails[j];
+                            if (heads[j] + data.durations[j] + data.durations[i] + tails[i] < limit) continue;
+                            if (heads[j] < before) heads[j] = before, changed = 1;
+                            if (tails[i] < after) tails[i] = after, changed = 1;
+                        }
+                        if (tasks.size() < 2) continue;
+                        if (heads[i] + total + other_tail >= limit and heads[i] < other_end)
+                            heads[i] = other_end, changed = 1;
+                        if (other_head + total + tails[i] >= limit and tails[i] < other_delivery)
+                            tails[i] = other_delivery, changed = 1;
+                    }
+                }
+                for (size_t job = 0; job < data.jobs_count; job++) {
+                    const size_t first = data.index(job, state.next_operation[job]), last = data.index(job + 1, 0);
+                    for (size_t index = first; index + 1 < last; index++)
+                        heads[index + 1] = std::max(heads[index + 1], heads[index] + data.durations[index]);
+                    for (size_t index = last; index-- > first + 1;)
+                        tails[index - 1] = std::max(tails[index - 1], data.durations[index] + tails[index]);
+                    for (size_t index = first; index < last; index++)
+                        if (heads[index] + data.durations[index] + tails[index] >= limit) return false;
+                }
+            }
+            return true;
+        }
+
+        /** Bound of the node, valid for the schedules shorter than <code>limit</code>; at least limit if none is. */
+        [[nodiscard]] time32_t lower_bound(node_state& state, time32_t limit) const {
+            time32_t bound = 0;
+            for (auto& tasks : state.machine_tasks) tasks.clear();
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                time32_t head = state.job_ready[job];
+                for (size_t i = state.next_operation[job]; i < data.machines_count; i++) {
+                    const size_t index = data.index(job, i);
+                    head = std::max(head, state.machine_ready[data.machines[index]]);
+                    state.heads[index] = head;
+                    state.tails[index] = job_tails[index];
+                    state.machine_tasks[data.machines[index]].push_back(uint32_t(index));
+                    head += data.durations[index];
+                }
+                bound = std::max(bound, head);
+            }
+            if (bound >= limit or not select(state, limit)) return limit;
+            for (auto& tasks : state.machine_tasks) {
+                if (tasks.empty()) continue;
+                for (size_t i = 1; i < tasks.size(); i++)
+                    for (size_t j = i; j > 0 and state.heads[tasks[j]] < state.heads[tasks[j - 1]]; j--)
+                        std::swap(tasks[j], tasks[j - 1]);
+                bound = std::max(bound, preemptive_makespan(state, tasks));
+            }
+            return bound;
+        }
+
+        void record(const node_state& state) {
+            const time32_t makespan = *std::max_element(state.job_ready.begin(), state.job_ready.end());
+            std::lock_guard lock(best_mutex);
+            if (makespan >= upper.load(std::memory_order_relaxed)) return;
+            std::copy(state.starts.begin(), state.starts.end(), best.scheduled_times.begin());
+            upper.store(makespan, std::memory_order_relaxed);
+        }
+
+        /** Counts the node and stops the search at the node limit, the time limit or a stop request. */
+        void count(node_state& state) {
+            const uint64_t explored = nodes.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (node_limit > 0 and explored >= node_limit) aborted.store(true, std::memory_order_relaxed);
+            if (++state.nodes % check_interval == 0 and (clock.get_elapsed_time() >= time_limit_us
+                                                         or (stop != nullptr
+                                                             and stop->load(std::memory_order_relaxed))))
+                aborted.store(true, std::memory_order_relaxed);
+        }
+
+        void branch(node_state& state, size_t depth, thread_pool& pool) {
+            count(state);
+            if (depth == data.tasks_count()) return record(state);
+
+            time32_t earliest_end = std::numeric_limits<time32_t>::max();
+            size_t earliest_job = 0;
+            id32_t machine = 0;
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                if (state.next_operation[job] == data.machines_count) continue;
+                const size_t index = data.index(job, state.next_operation[job]);
+                const time32_t end = std::max(state.job_ready[job], state.machine_ready[data.machines[index]])
+                                     + data.durations[index];
+                if (end < earliest_end) earliest_end = end, earliest_job = job, machine = data.machines[index];
+            }
+            const auto head_of = [&](size_t job) {
+                return std::max(state.job_ready[job], state.machine_ready[machine]);
+            };
+            const auto conflicts = [&](size_t job) {
+                if (state.next_operation[job] == data.machines_count) return false;
+                const size_t index = data.index(job, state.next_operation[job]);
+                return data.machines[index] == machine and (head_of(job) < earliest_end or job == earliest_job);
+            };
+
+            auto& children = state.children[depth];
+            children.clear();
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                if (not conflicts(job)) continue;
+                const time32_t end = head_of(job) + data.durations[data.index(job, state.next_operation[job])];
+                bool selectable = true;
+                for (size_t other = 0; other < data.jobs_count and selectable; other++) {
+                    if (other == job or not conflicts(other)) continue;
+                    const size_t index = data.index(other, state.next_operation[other]);
+                    selectable = std::max(head_of(other), end) + data.durations[index] + job_tails[index]
+                                 < upper.load(std::memory_order_relaxed);
+                }
+                if (not selectable) continue;
+                const auto previous = apply(state, uint32_t(job));
+                const time32_t bound = lower_bound(state, upper.load(std::memory_order_relaxed));
+                undo(state, uint32_t(job), previous);
+                if (bound < upper.load(std::memory_order_relaxed)) children.push_back({bound, uint32_t(job)});
+            }
+            std::sort(children.begin(), children.end(), [](const child& a, const child& b) {
+                return std::pair(a.bound, a.job) < std::pair(b.bound, b.job);
+            });
+
+            if (pool.size() > 0 and depth < parallel_depth and children.size() > 1) {
+                pool.parallel_for(children.size(), [&](size_t c) {
+                    if (finished() or children[c].bound >= upper.load(std::memory_order_relaxed)) return;
+                    node_state copy = state;
+                    apply(copy, children[c].job);
+                    branch(copy, depth + 1, pool);
+                });
+                return;
+            }
+            for (const child& child : children) {
+                if (finished() or child.bound >= upper.load(std::memory_order_relaxed)) return;
+                const auto previous = apply(state, child.job);
+                branch(state, depth + 1, pool);
+                undo(state, child.job, previous);
+            }
+        }
+
+    public:
+
+        struct statistics {
+            uint64_t nodes = 0, elapsed_us = 0;
+            bool complete = false;
+        };
+
+        explicit branch_and_bound(const instance& data) : data(data), job_tails(data.tasks_count()), best(data) {
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                time32_t tail = 0;
+                for (size_t i = data.machines_count; i-- > 0;) {
+                    job_tails[data.index(job, i)] = tail;
+                    tail += data.duration(job, i);
+                }
+            }
+        }
+
+        /**
+         * Searches for a schedule shorter than the incumbent, stopping early once one reaches the lower bound. The
+         * statistics tell whether the search was complete, which proves the best schedule optimal; otherwise it was
+         * cut by the node limit, the time limit or a stop request and the best schedule is only the best found.
+         */
+        statistics run(thread_pool& pool, const solution_state& incumbent, time32_t incumbent_makespan,
+                       time32_t lower, uint64_t max_nodes, uint64_t max_time_us,
+                       const std::atomic<bool>* stop_request = nullptr) {
+            clock = {};
+            clock.start();
+            best.scheduled_times = incumbent.scheduled_times;
+            upper = incumbent_makespan;
+            nodes = 0;
+            aborted = false;
+            target = lower;
+            node_limit = max_nodes;
+            time_limit_us = max_time_us;
+            stop = stop_request;
+
+            node_state root;
+            root.next_operation.assign(data.jobs_count, 0);
+            root.job_ready.assign(data.jobs_count, 0);
+            root.machine_ready.assign(data.machines_count, 0);
+            root.starts.assign(data.tasks_count(), 0);
+            root.heads.assign(data.tasks_count(), 0);
+            root.tails.assign(data.tasks_count(), 0);
+            root.machine_tasks.resize(data.machines_count);
+            root.children.resize(data.tasks_count());
+            if (not finished() and lower_bound(root, upper) < upper) branch(root, 0, pool);
+
+            clock.stop();
+            return {nodes.load(), uint64_t(clock.get_measured_time()), not aborted.load()};
+        }
+
+        [[nodiscard]] time32_t best_makespan_found() const {
+            return upper.load();
+        }
+
+        [[nodiscard]] const solution_state& best_solution() const {
+            return best;
+        }
+    };
+}
+
+#endif //JOB_SHOP_BRANCH_AND_BOUND
@@ -0,0 +1,184 @@
+#ifndef JOB_SHOP_CACHE
+#define JOB_SHOP_CACHE
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <vector>
+#include "dataset.hpp"
+
+namespace js {
+
+    /** Streaming 64-bit hash of machine words: a multiply-xorshift round per word and a final avalanche. */
+    class fingerprint {
+
+        uint64_t state = 0x9e3779b97f4a7c15;
+
+    public:
+
+        fingerprint& add(uint64_t word) {
+            state = (state ^ word) * 0xff51afd7ed558ccd;
+            state ^= state >> 32;
+            return *this;
+        }
+
+        fingerprint& add(std::string_view text) {
+            add(text.size());
+            for (const char c : text) add(uint8_t(c));
+            return *this;
+        }
+
+        /** Hashes the parsed instance, so files that differ only in layout share a fingerprint. */
+        fingerprint& add(const instance& data) {
+            add(data.jobs_count).add(data.machines_count);
+            for (size_t i = 0; i < data.tasks_count(); i++)
+                add(uint64_t(uint32_t(data.machines[i])) | uint64_t(data.durations[i]) << 32);
+            add(data.eligible.size());
+            for (const uint32_t offset : data.eligible_offsets) add(offset);
+            for (const id32_t machine : data.eligible) add(uint32_t(machine));
+            add(data.downtimes.size());
+            for (const auto& downtime : data.downtimes)
+                add(uint32_t(downtime.machine)).add(uint64_t(downtime.start) | uint64_t(downtime.end) << 32);
+            return *this;
+        }
+
+        [[nodiscard]] uint64_t value() const {
+            uint64_t result = state;
+            result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9;
+            result = (result ^ (result >> 27)) * 0x94d049bb133111eb;
+            return result ^ (result >> 31);
+        }
+    };
+
+    /**
+     * On-disk cache of solutions, one file per key named after it in hexadecimal, in the binary solution format.
+     * Entries are written to a temporary file and renamed, so concurrent readers only see complete entries. A hit
+     * refreshes the modification time of its file; once the entries exceed the capacity, the least recently used
+     * ones are removed.
+     *
+     * The directory is scanned on the first store and whenever the running total of its size exceeds the capacity;
+     * a scan also removes temporary files left behind by writers that died. Storing is best effort: a failure is
+     * reported on the error stream and leaves the cache as it was.
+     */
+    class solution_cache {
+
+        const std::filesystem::path directory;
+        const uintmax_t capacity;
+        std::mutex eviction_mutex;
+        uintmax_t total = 0;
+        bool scanned = false;
+        std::atomic<uint64_t> writes = 0;
+        const uint32_t writer = std::random_device{}();
+
+        static constexpr std::string_view extension = ".sol";
+        static constexpr auto stale_after = std::chrono::minutes(10);
+
+        [[nodiscard]] std::filesystem::path entry(uint64_t key) const {
+            std::ostringstream name;
+            name << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+            return directory / name.str();
+        }
+
+        /** Recounts the total size, removing stale temporary files, then the least recently used entries if needed. */
+        void scan() {
+            std::error_code error;
+            std::vector<std::tuple<std::filesystem::file_time_type, uintmax_t, std::filesystem::path>> entries;
+            const auto now = std::filesystem::file_time_type::clock::now();
+            total = 0;
+            for (std::filesystem::directory_iterator file(directory, error), end; not error and file != end;
+                 file.increment(error)) {
+                const std::string name = file->path().filename().string();
+                const size_t position = name.find(extension);
+                if (position == std::string::npos) continue;
+                std::error_code file_error;
+                const uintmax_t size = file->file_size(file_error);
+                const auto time = file->last_write_time(file_error);
+                if (file_error) continue;
+                if (position + extension.size() < name.size()) {
+                    if (now - time > stale_after and std::filesystem::remove(file->path(), file_error)) continue;
+                } else entries.emplace_back(time, size, file->path());
+                total += size;
+            }
+            scanned = true;
+            if (total <= capacity) return;
+            std::sort(entries.begin(), entries.end());
+            for (const auto& [time, size, path] : entries) {
+                if (total <= capacity) break;
+                if (std::filesystem::remove(path, error)) total -= size;
+            }
+        }
+
+        /** Accounts for a stored entry that replaced <code>replaced</code> bytes, evicting once over capacity. */
+        void account(uintmax_t size, uintmax_t replaced) {
+            std::lock_guard lock(eviction_mutex);
+            if (not scanned) return scan();
+            total = total - std::min(total, replaced) + size;
+            if (total > capacity) scan();
+        }
+
+    public:
+
+        solution_cache(const std::string& directory, uintmax_t capacity) : directory(directory), capacity(capacity) {
+            std::filesystem::create_directories(this->directory);
+        }
+
+        /** Loads the entry of a key; a missing or unreadable entry is a miss, and an unreadable one is removed. */
+        bool lookup(uint64_t key, solution_record& record) {
+            const std::filesystem::path path = entry(key);
+            std::error_code error;
+            if (not std::filesystem::exists(path, error)) return false;
+            try {
+                record.load_from_file(path.string());
+            } catch (const std::exception&) {
+                std::filesystem::remove(path, error);
+                return false;
+            }
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+            return true;
+        }
+
+        /** Stores the entry of a key, reporting rather than throwing when it cannot be written. */
+        void store(uint64_t key, const solution_record& record) {
+            const std::filesystem::path path = entry(key);
+            std::filesystem::path temporary = path;
+            temporary += ".tmp" + std::to_string(writer) + "-" + std::to_string(writes++);
+            std::error_code error;
+            errno = 0;
+            {
+                std::ofstream output(temporary, std::ios::binary);
+                if (output) {
+                    record.write_binary(output);
+                    output.flush();
+                }
+                if (not output) error = errno != 0 ? std::error_code(errno, std::generic_category())
+                                                   : std::make_error_code(std::errc::io_error);
+            }
+            const uintmax_t size = error ? 0 : std::filesystem::file_size(temporary, error);
+            std::error_code missing;
+            const uintmax_t replaced = std::filesystem::file_size(path, missing);
+            if (not error) std::filesystem::rename(temporary, path, error);
+            if (error) {
+                std::filesystem::remove(temporary, missing);
+                std::cerr << "Could not store cache entry " << path.string() << ": " << error.message() << std::endl;
+                return;
+            }
+            account(size, missing ? 0 : replaced);
+        }
+    };
+}
+
+#endif //JOB_SHOP_CACHE
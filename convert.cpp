@@ -1,60 +1,110 @@
 #include <fstream>
 #include <iostream>
-#include <vector>
+#include "binary.hpp"
 #include "dataset.hpp"
+#include "generator.hpp"
 #include "platform.hpp"
 
-void discard_next(std::istream& file, size_t count) {
-    std::string discard;
-    for (size_t i = 0; i < count; i++) file >> discard;
+enum class target { orlib, binary, text };
+
+/** Returns true if the first non-empty line of a text file holds a single number, as in a stored solution. */
+bool is_text_solution(std::string_view data) {
+    js::scanner scanner(data.substr(0, data.find('\n')));
+    for (int tokens = 0;; tokens++) {
+        if (scanner.at_end()) return tokens == 1;
+        (void) scanner.next<uint64_t>();
+    }
 }
 
-void convert(const std::string& input, const std::string& output) {
+void convert(const std::string& input, const std::string& output, target to) {
 
-    js::create_directory(output);
-    std::ifstream input_file(input);
-    std::ofstream output_file(output);
+    const js::mapped_file file(input);
+    const std::string_view data = file.view();
 
-    if (not input_file.is_open()) throw std::runtime_error("Could not open file " + std::string(input));
+    js::create_directory(output);
+    std::ofstream output_file(output, std::ios::binary);
     if (not output_file.is_open()) throw std::runtime_error("Could not open file " + std::string(output));
 
-    js::id32_t jobs_count = 0, machines_count = 0;
-    size_t tasks_count = 0;
-    std::vector<js::time32_t> times;
-    std::vector<js::id32_t> machines;
-
-    while (not input_file.eof()) {
-
-        input_file >> jobs_count >> machines_count;
-        tasks_count = jobs_count * machines_count;
-
-        times.reserve(tasks_count);
-        discard_next(input_file, 5);
-        for (size_t i = 0; i < tasks_count; i++) input_file >> times[i];
-
-        machines.reserve(tasks_count);
-        discard_next(input_file, 1);
-        for (size_t i = 0; i < tasks_count; i++) input_file >> machines[i];
+    if (to == target::orlib) {
+        js::instance instance;
+        instance.load_taillard_from_memory(data);
+        instance.write(output_file);
+    } else if (js::binary::has_magic(data, js::binary::solution_magic) or
+               (not js::binary::has_magic(data, js::binary::instance_magic) and is_text_solution(data))) {
+        js::solution_record solution;
+        solution.load_from_memory(data);
+        if (to == target::binary) solution.write_binary(output_file);
+        else solution.write(output_file);
+    } else {
+        js::instance instance;
+        if (js::binary::has_magic(data, js::binary::instance_magic)) instance.load_binary_from_memory(data);
+        else instance.load_from_memory(data);
+        if (to == target::binary) instance.write_binary(output_file);
+        else instance.write(output_file);
     }
-    input_file.close();
+    output_file.close();
+}
 
-    output_file << jobs_count << " " << machines_count << std::endl;
-    for (size_t i = 0; i < tasks_count;) {
-        output_file << machines[i] % machines_count << " " << times[i] << " ";
-        if (++i % machines_count == 0) output_file << std::endl;
+/**
+ * Writes a random instance: <code>--generate output jobs machines [--seed s] [--durations min max]
+ * [--distribution uniform|exponential] [--to-binary]</code>.
+ */
+void generate(int argc, char** argv) {
+    if (argc < 5) throw std::runtime_error("Usage: --generate <output> <jobs> <machines> [options]");
+    const std::string output = argv[2];
+    const size_t jobs_count = std::stoul(argv[3]), machines_count = std::stoul(argv[4]);
+    uint32_t seed = 1;
+    js::time32_t min_duration = 1, max_duration = 99;
+    js::duration_distribution distribution = js::duration_distribution::uniform;
+    target to = target::text;
+    for (int i = 5; i < argc; i++) {
+        if (std::string(argv[i]) == "--seed") seed = std::stoul(argv[++i]);
+        else if (std::string(argv[i]) == "--durations") {
+            min_duration = std::stoul(argv[++i]);
+            max_duration = std::stoul(argv[++i]);
+        } else if (std::string(argv[i]) == "--distribution")
+            distribution = js::parse_duration_distribution(argv[++i]);
+        else if (std::string(argv[i]) == "--to-binary") to = target::binary;
+        else throw std::runtime_error("Unknown option " + std::string(argv[i]));
     }
-    output_file.close();
+
+    const js::instance instance = js::generate_instance(seed, jobs_count, machines_count, min_duration,
+                                                        max_duration, distribution);
+    js::create_directory(output);
+    std::ofstream output_file(output, std::ios::binary);
+    if (not output_file.is_open()) throw std::runtime_error("Could not open file " + output);
+    if (to == target::binary) instance.write_binary(output_file);
+    else instance.write(output_file);
 }
 
 int main(int argc, char** argv) {
 
+    if (argc > 1 and std::string(argv[1]) == "--generate") {
+        generate(argc, argv);
+        return 0;
+    }
+
     if (argc < 3) {
-        std::cout << "Convert a tailard format instance to orlib format" << std::endl;
-        std::cout << "Usage: " << js::extract_file_name(argv[0]) << " <input> <output> [-d]" << std::endl;
+        std::cout << "Convert a tailard format instance to orlib format, or an instance or a solution between the "
+                     "text and binary formats" << std::endl;
+        std::cout << "Usage: " << js::extract_file_name(argv[0]) << " <input> <output> [-d] [--to-binary | --to-text]"
+                  << std::endl;
+        std::cout << "       " << js::extract_file_name(argv[0]) << " --generate <output> <jobs> <machines> "
+                     "[--seed <seed>] [--durations <min> <max>] [--distribution uniform|exponential] [--to-binary]"
+                  << std::endl;
         return 1;
     }
 
-    if (argc > 3 and std::string(argv[3]) == "-d") {
+    bool directory = false;
+    target to = target::orlib;
+    for (int i = 3; i < argc; i++) {
+        if (std::string(argv[i]) == "-d") directory = true;
+        else if (std::string(argv[i]) == "--to-binary") to = target::binary;
+        else if (std::string(argv[i]) == "--to-text") to = target::text;
+        else throw std::runtime_error("Unknown option " + std::string(argv[i]));
+    }
+
+    if (directory) {
         const std::string input_directory = argv[1], output_directory = argv[2];
         js::create_directory(output_directory);
         for (const auto& entry : std::filesystem::directory_iterator(input_directory)) {
@@ -62,7 +112,7 @@ int main(int argc, char** argv) {
             const std::string input = path.string();
             const std::string output = (std::ostringstream{} << output_directory << js::path_sep
                                                              << path.filename().string()).str();
-            convert(input, output);
+            convert(input, output, to);
         }
-    } else convert(argv[1], argv[2]);
-}
\ No newline at end of file
+    } else convert(argv[1], argv[2], to);
+}
@@ -1,52 +1,372 @@
 #ifndef JOB_SHOP_DATASET
 #define JOB_SHOP_DATASET
 
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
+#include "binary.hpp"
+#include "parser.hpp"
+#include "platform.hpp"
 
 namespace js {
 
     typedef uint32_t time32_t;
     typedef int32_t id32_t;
 
-    struct task {
+    /** Interval <code>[start, end)</code> in which a machine is unavailable, such as planned maintenance. */
+    struct downtime {
+        id32_t machine;
+        time32_t start, end;
+    };
+
+    /**
+     * Immutable problem definition. Machine ids and durations are stored as flat arrays indexed by
+     * <code>job * machines_count + operation</code>.
+     *
+     * A flexible instance lets a task run on any of several machines, with the same duration on each: the eligible
+     * machines of task <code>i</code> are <code>eligible[eligible_offsets[i]]</code> up to
+     * <code>eligible[eligible_offsets[i + 1]]</code>, the first being <code>machines[i]</code>. Both arrays are empty
+     * for a classic instance. Downtimes are machine intervals no task may overlap.
+     */
+    struct instance {
+
+        size_t machines_count = 0, jobs_count = 0;
+        std::vector<id32_t> machines;
+        std::vector<time32_t> durations;
+        std::vector<uint32_t> eligible_offsets;
+        std::vector<id32_t> eligible;
+        std::vector<downtime> downtimes;
+
+        [[nodiscard]] size_t tasks_count() const {
+            return jobs_count * machines_count;
+        }
+
+        [[nodiscard]] size_t index(size_t job, size_t operation) const {
+            return job * machines_count + operation;
+        }
+
+        [[nodiscard]] id32_t machine(size_t job, size_t operation) const {
+            return machines[index(job, operation)];
+        }
+
+        [[nodiscard]] time32_t duration(size_t job, size_t operation) const {
+            return durations[index(job, operation)];
+        }
+
+        [[nodiscard]] bool flexible() const {
+            return not eligible_offsets.empty();
+        }
+
+        /** One fixed machine per task and no downtimes, as every engine supports. */
+        [[nodiscard]] bool classic() const {
+            return not flexible() and downtimes.empty();
+        }
+
+        [[nodiscard]] std::span<const id32_t> eligible_machines(size_t index) const {
+            if (not flexible()) return {machines.data() + index, 1};
+            return {eligible.data() + eligible_offsets[index], eligible_offsets[index + 1] - eligible_offsets[index]};
+        }
+
+        /**
+         * Loads the ORLib text format: the jobs and machines counts, then a <code>machine duration</code> pair per
+         * task. Two optional sections may follow: <code>eligible</code> with <code>job operation count
+         * machine...</code> entries giving a task alternative machines besides its own, and <code>downtime</code>
+         * with <code>machine start end</code> entries.
+         */
+        void load_from_memory(std::string_view data_string, uint16_t limit = 0) {
+            scanner scanner(data_string);
+            jobs_count = scanner.next<uint32_t>();
+            machines_count = scanner.next<uint32_t>();
+            const size_t listed_jobs = jobs_count;
+            if (limit > 0) jobs_count = std::min(jobs_count, size_t(limit));
+            machines.resize(tasks_count());
+            durations.resize(tasks_count());
+            for (size_t i = 0; i < tasks_count(); i++) {
+                machines[i] = scanner.next<id32_t>(machines_count - 1);
+                durations[i] = scanner.next<time32_t>();
+            }
+            scanner.skip(2 * (listed_jobs - jobs_count) * machines_count);
+
+            eligible_offsets.clear();
+            eligible.clear();
+            downtimes.clear();
+            std::vector<std::pair<size_t, id32_t>> alternatives;
+            while (not scanner.at_end()) {
+                if (scanner.accept("eligible"))
+                    while (scanner.at_number()) {
+                        const auto job = scanner.next<uint32_t>(listed_jobs - 1);
+                        const auto operation = scanner.next<uint32_t>(machines_count - 1);
+                        for (auto count = scanner.next<uint32_t>(machines_count); count > 0; count--) {
+                            const auto machine = scanner.next<id32_t>(machines_count - 1);
+                            if (job < jobs_count) alternatives.emplace_back(index(job, operation), machine);
+                        }
+                    }
+                else if (scanner.accept("downtime"))
+                    while (scanner.at_number()) {
+                        const auto machine = scanner.next<id32_t>(machines_count - 1);
+                        const auto start = scanner.next<time32_t>(), end = scanner.next<time32_t>();
+                        if (start >= end) scanner.fail("downtime ends before it starts");
+                        downtimes.push_back({machine, start, end});
+                    }
+                else scanner.fail("expected an eligible or downtime section");
+            }
+            if (alternatives.empty()) return;
+            std::stable_sort(alternatives.begin(), alternatives.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+            eligible_offsets.assign(tasks_count() + 1, 0);
+            eligible.reserve(tasks_count() + alternatives.size());
+            auto alternative = alternatives.begin();
+            for (size_t i = 0; i < tasks_count(); i++) {
+                eligible_offsets[i] = uint32_t(eligible.size());
+                eligible.push_back(machines[i]);
+                for (; alternative != alternatives.end() and alternative->first == i; ++alternative)
+                    if (std::find(eligible.begin() + eligible_offsets[i], eligible.end(), alternative->second)
+                        == eligible.end())
+                        eligible.push_back(alternative->second);
+            }
+            eligible_offsets[tasks_count()] = uint32_t(eligible.size());
+        }
+
+        void load_binary_from_memory(std::string_view data, uint16_t limit = 0) {
+            const auto [version, jobs, machines_per_job] = binary::read_header(data, binary::instance_magic,
+                                                                               binary::instance_header_size, 2);
+            jobs_count = limit > 0 ? std::min(size_t(jobs), size_t(limit)) : jobs;
+            machines_count = machines_per_job;
+            machines.resize(tasks_count());
+            durations.resize(tasks_count());
+            eligible_offsets.clear();
+            eligible.clear();
+            downtimes.clear();
+            const uint64_t stored_tasks = uint64_t(jobs) * machines_count;
+            const char* arrays = data.data() + binary::instance_header_size;
+            binary::read_array(arrays, machines.data(), tasks_count());
+            binary::read_array(arrays + 4 * stored_tasks, durations.data(), tasks_count());
+            for (const id32_t machine : machines)
+                if (machine < 0 or size_t(machine) >= machines_count)
+                    throw std::runtime_error("Binary instance refers to machine " + std::to_string(machine));
+            if (version == 1) return;
+
+            const uint64_t sections = binary::instance_header_size + 8 * stored_tasks;
+            if (data.size() < sections + 8) binary::check_size(data, binary::instance_magic, sections + 8);
+            const auto eligible_count = binary::read<uint32_t>(data.data() + sections);
+            const auto downtimes_count = binary::read<uint32_t>(data.data() + sections + 4);
+            const uint64_t offsets_count = eligible_count > 0 ? stored_tasks + 1 : 0;
+            binary::check_size(data, binary::instance_magic,
+                               sections + 8 + 4 * (offsets_count + eligible_count + 3 * uint64_t(downtimes_count)));
+            const char* offsets = data.data() + sections + 8;
+            if (eligible_count > 0) {
+                eligible_offsets.resize(tasks_count() + 1);
+                binary::read_array(offsets, eligible_offsets.data(), eligible_offsets.size());
+                bool consistent = eligible_offsets.front() == 0
+                                  and binary::read<uint32_t>(offsets + 4 * stored_tasks) == eligible_count;
+                for (size_t i = 0; i < tasks_count(); i++)
+                    consistent = consistent and eligible_offsets[i] < eligible_offsets[i + 1];
+                if (not consistent)
+                    throw std::runtime_error("Binary instance has inconsistent eligible machine offsets");
+                eligible.resize(eligible_offsets.back());
+                binary::read_array(offsets + 4 * offsets_count, eligible.data(), eligible.size());
+                for (size_t i = 0; i < tasks_count(); i++)
+                    if (eligible[eligible_offsets[i]] != machines[i])
+                        throw std::runtime_error("Binary instance does not list the machine of a task first");
+                for (const id32_t machine : eligible)
+                    if (machine < 0 or size_t(machine) >= machines_count)
+                        throw std::runtime_error("Binary instance refers to machine " + std::to_string(machine));
+            }
+            const char* records = offsets + 4 * (offsets_count + eligible_count);
+            for (size_t i = 0; i < downtimes_count; i++, records += 12) {
+                const downtime downtime{binary::read<id32_t>(records), binary::read<time32_t>(records + 4),
+                                        binary::read<time32_t>(records + 8)};
+                if (downtime.machine < 0 or size_t(downtime.machine) >= machines_count
+                    or downtime.start >= downtime.end)
+                    throw std::runtime_error("Binary instance has an invalid downtime");
+                downtimes.push_back(downtime);
+            }
+        }
 
-        struct job& parent;
-        id32_t machine_id = 0;
-        time32_t duration = 0, scheduled_time = 0;
+        /**
+         * Loads an instance in either the ORLib text format or the binary format, recognized by its magic number.
+         */
+        void load_from_file(const std::string& path, uint16_t limit = 0) {
+            const mapped_file file(path);
+            if (binary::has_magic(file.view(), binary::instance_magic)) load_binary_from_memory(file.view(), limit);
+            else load_from_memory(file.view(), limit);
+        }
+
+        void write_binary(std::ostream& output) const {
+            binary::write_header(output, binary::instance_magic, jobs_count, machines_count, classic() ? 1 : 2);
+            binary::write_array(output, machines.data(), tasks_count());
+            binary::write_array(output, durations.data(), tasks_count());
+            if (classic()) return;
+            binary::write<uint32_t>(output, uint32_t(eligible.size()));
+            binary::write<uint32_t>(output, uint32_t(downtimes.size()));
+            binary::write_array(output, eligible_offsets.data(), eligible_offsets.size());
+            binary::write_array(output, eligible.data(), eligible.size());
+            for (const auto& downtime : downtimes) {
+                binary::write<id32_t>(output, downtime.machine);
+                binary::write<time32_t>(output, downtime.start);
+                binary::write<time32_t>(output, downtime.end);
+            }
+        }
 
-        explicit task(job& parent) : parent(parent) {}
+        void write(std::ostream& output) const {
+            output << jobs_count << " " << machines_count << std::endl;
+            for (size_t i = 0; i < tasks_count();) {
+                output << machines[i] << " " << durations[i] << " ";
+                if (++i % machines_count == 0) output << std::endl;
+            }
+            if (flexible()) {
+                output << "eligible\n";
+                for (size_t i = 0; i < tasks_count(); i++) {
+                    const auto alternatives = eligible_machines(i).subspan(1);
+                    if (alternatives.empty()) continue;
+                    output << i / machines_count << ' ' << i % machines_count << ' ' << alternatives.size();
+                    for (const id32_t machine : alternatives) output << ' ' << machine;
+                    output << '\n';
+                }
+            }
+            if (not downtimes.empty()) output << "downtime\n";
+            for (const auto& downtime : downtimes)
+                output << downtime.machine << ' ' << downtime.start << ' ' << downtime.end << '\n';
+        }
+
+        /**
+         * Loads the last instance of a file in Taillard's format (size and seeds header, then the "Times" and
+         * "Machines" matrices with 1-based machine numbers).
+         */
+        void load_taillard_from_memory(std::string_view data_string) {
+            scanner scanner(data_string);
+            while (not scanner.at_end()) {
+                jobs_count = scanner.next<uint32_t>();
+                machines_count = scanner.next<uint32_t>();
+                machines.resize(tasks_count());
+                durations.resize(tasks_count());
+                scanner.skip(5);
+                for (size_t i = 0; i < tasks_count(); i++) durations[i] = scanner.next<time32_t>();
+                scanner.skip(1);
+                for (size_t i = 0; i < tasks_count(); i++)
+                    machines[i] = scanner.next<id32_t>() % id32_t(machines_count);
+            }
+        }
     };
 
-    struct job {
+    /**
+     * Mutable per-run scheduling state of an instance. Resetting keeps the storage, so a single state can be reused
+     * for any number of runs without allocating.
+     */
+    struct solution_state {
+
+        std::vector<time32_t> scheduled_times, job_ends;
+        std::vector<id32_t> assigned_machines;
 
-        id32_t id;
-        std::vector<task> sequence;
-        time32_t last_scheduled_time = 0;
+        solution_state() = default;
 
-        explicit job(id32_t id) : id(id) {}
+        explicit solution_state(const instance& data) {
+            reset(data);
+        }
+
+        void reset(const instance& data) {
+            scheduled_times.assign(data.tasks_count(), 0);
+            job_ends.assign(data.jobs_count, 0);
+            if (data.flexible()) assigned_machines.assign(data.machines.begin(), data.machines.end());
+            else assigned_machines.clear();
+        }
+
+        /** The machine a task runs on: its assigned one in a flexible instance, its only one otherwise. */
+        [[nodiscard]] id32_t machine(const instance& data, size_t index) const {
+            return assigned_machines.empty() ? data.machines[index] : assigned_machines[index];
+        }
     };
 
-    struct dataset {
+    /**
+     * Stored solution: the makespan and the start time of every task, read from the text summary format (makespan,
+     * then one line of start times per job) or from the binary format. A solution of a flexible instance also lists
+     * the machine of every task, in the text format only: a <code>machines</code> line, then one line per job.
+     */
+    struct solution_record {
 
-        size_t machines_count = 0, jobs_count = 0;
-        std::vector<job> jobs;
-
-        void load_from_memory(const std::string& data_string, uint16_t limit = 0) {
-            std::istringstream data_stream(data_string);
-            data_stream >> jobs_count;
-            data_stream >> machines_count;
-            if (limit > 0) jobs_count = limit;
-            jobs.reserve(jobs_count);
-            for (id32_t i = 0; i < jobs_count; i++) {
-                job& t = jobs.emplace_back(i);
-                t.sequence.reserve(machines_count);
-                for (id32_t j = 0; j < machines_count; j++) {
-                    task& st = t.sequence.emplace_back(t);
-                    data_stream >> st.machine_id;
-                    data_stream >> st.duration;
-                }
+        size_t jobs_count = 0, machines_count = 0;
+        time32_t makespan = 0;
+        std::vector<time32_t> start_times;
+        std::vector<id32_t> machines;
+
+        void load_from_memory(std::string_view data) {
+            machines.clear();
+            if (binary::has_magic(data, binary::solution_magic)) {
+                const auto [version, jobs, machines_per_job] = binary::read_header(data, binary::solution_magic,
+                                                                                   binary::solution_header_size, 1);
+                jobs_count = jobs;
+                machines_count = machines_per_job;
+                makespan = binary::read<uint32_t>(data.data() + 16);
+                const auto machines_listed = binary::read<uint32_t>(data.data() + 20);
+                if (machines_listed > (version > 1))
+                    throw std::runtime_error("Binary solution has an invalid machines flag");
+                const size_t tasks_count = jobs_count * machines_count;
+                binary::check_size(data, binary::solution_magic,
+                                   binary::solution_header_size + 4 * (1 + machines_listed) * uint64_t(tasks_count));
+                const char* arrays = data.data() + binary::solution_header_size;
+                start_times.resize(tasks_count);
+                binary::read_array(arrays, start_times.data(), tasks_count);
+                machines.resize(machines_listed ? tasks_count : 0);
+                binary::read_array(arrays + 4 * tasks_count, machines.data(), machines.size());
+                return;
+            }
+            scanner scanner(data);
+            makespan = scanner.next<time32_t>();
+            start_times.clear();
+            jobs_count = machines_count = 0;
+            size_t row = 0;
+            bool machine_lines = false;
+            for (size_t line_start = data.find('\n'); line_start != std::string_view::npos;) {
+                const size_t line_end = data.find('\n', line_start + 1);
+                const std::string_view line = data.substr(line_start + 1, line_end - line_start - 1);
+                js::scanner line_scanner(line);
+                size_t count = 0;
+                if (not machine_lines and line_scanner.accept("machines")) machine_lines = true, row = 0;
+                else if (machine_lines)
+                    for (; not line_scanner.at_end(); count++) machines.push_back(line_scanner.next<id32_t>());
+                else for (; not line_scanner.at_end(); count++) start_times.push_back(line_scanner.next<time32_t>());
+                if (count > 0 and (row > 0 or machine_lines) and count != machines_count)
+                    scanner.fail("job " + std::to_string(row) + " has " + std::to_string(count)
+                                 + (machine_lines ? " machines" : " start times") + " instead of "
+                                 + std::to_string(machines_count), line_start + 1);
+                if (count > 0) row++;
+                if (count > 0 and not machine_lines) machines_count = count, jobs_count++;
+                line_start = line_end;
+            }
+            if (not machines.empty() and machines.size() != start_times.size())
+                scanner.fail("machines are listed for " + std::to_string(machines.size() / machines_count)
+                             + " jobs instead of " + std::to_string(jobs_count), data.size());
+        }
+
+        void load_from_file(const std::string& path) {
+            load_from_memory(mapped_file(path).view());
+        }
+
+        void write(std::ostream& output) const {
+            output << makespan << '\n';
+            for (size_t i = 0; i < start_times.size();) {
+                output << start_times[i] << ' ';
+                if (++i % machines_count == 0) output << '\n';
             }
+            if (not machines.empty()) output << "machines\n";
+            for (size_t i = 0; i < machines.size();) {
+                output << machines[i] << ' ';
+                if (++i % machines_count == 0) output << '\n';
+            }
+        }
+
+        void write_binary(std::ostream& output) const {
+            binary::write_header(output, binary::solution_magic, jobs_count, machines_count, machines.empty() ? 1 : 2);
+            binary::write<uint32_t>(output, makespan);
+            binary::write<uint32_t>(output, not machines.empty());
+            binary::write_array(output, start_times.data(), start_times.size());
+            binary::write_array(output, machines.data(), machines.size());
         }
     };
 }
@@ -0,0 +1,133 @@
+#ifndef JOB_SHOP_ENGINES
+#define JOB_SHOP_ENGINES
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "dataset.hpp"
+#include "giffler_thompson.hpp"
+#include "heuristics.hpp"
+#include "schedule.hpp"
+#include "shifting_bottleneck.hpp"
+#include "thread_pool.hpp"
+
+namespace js {
+
+    /**
+     * Constructive solver bound to one instance. Engines keep their scratch buffers between runs, so a single engine
+     * must not be run concurrently.
+     */
+    class engine {
+
+    public:
+
+        virtual ~engine() = default;
+
+        virtual void run(schedule& schedule) = 0;
+
+        /**
+         * Runs the engine; engines that split their work into independent parts may spread them over the pool. The
+         * long engines poll <code>stop</code> once per operation or machine and return false, the schedule
+         * incomplete, when it ends the run early.
+         */
+        virtual bool run(schedule& schedule, thread_pool& pool, const stop_predicate& stop) {
+            run(schedule);
+            return true;
+        }
+    };
+
+    template<round_heuristic Heuristic>
+    class list_engine : public engine {
+
+    public:
+
+        explicit list_engine(const instance& data) {}
+
+        void run(schedule& schedule) override {
+            schedule.reset();
+            schedule.schedule_jobs<Heuristic>();
+        }
+    };
+
+    /** Giffler-Thompson engine; the tie break restarts on every run, so a random one is seeded the same each time. */
+    template<typename Rule, typename TieBreak = dispatch::lowest_id>
+    class active_engine : public engine {
+
+        giffler_thompson<Rule, TieBreak> generator;
+
+    public:
+
+        explicit active_engine(const instance& data) : generator(data) {}
+
+        void run(schedule& schedule) override {
+            generator.tie_break = TieBreak{};
+            generator.schedule_into(schedule);
+        }
+
+        bool run(schedule& schedule, thread_pool& pool, const stop_predicate& stop) override {
+            generator.tie_break = TieBreak{};
+            return generator.schedule_into(schedule, stop);
+        }
+    };
+
+    class shifting_bottleneck_engine : public engine {
+
+        shifting_bottleneck generator;
+
+    public:
+
+        explicit shifting_bottleneck_engine(const instance& data) : generator(data) {}
+
+        void run(schedule& schedule) override {
+            thread_pool inline_pool(0);
+            generator.schedule_into(schedule, inline_pool);
+        }
+
+        bool run(schedule& schedule, thread_pool& pool, const stop_predicate& stop) override {
+            return generator.schedule_into(schedule, pool, stop);
+        }
+    };
+
+    /** A registered engine; <code>general</code> ones also handle flexible instances and downtimes. */
+    struct engine_entry {
+        const char* name;
+        std::unique_ptr<engine> (* create)(const instance&);
+        bool general;
+    };
+
+    template<typename Engine>
+    std::unique_ptr<engine> make_engine(const instance& data) {
+        return std::make_unique<Engine>(data);
+    }
+
+    const std::vector<engine_entry>& engine_registry() {
+        static const std::vector<engine_entry> registry = {
+                {"pass",                make_engine<list_engine<heuristics::pass>>,                          true},
+                {"reverse",             make_engine<list_engine<heuristics::reversed>>,                      true},
+                {"stachu-ascending",    make_engine<list_engine<heuristics::stachu_ascending>>,              true},
+                {"stachu-descending",   make_engine<list_engine<heuristics::stachu_descending>>,             true},
+                {"active-spt",          make_engine<active_engine<dispatch::spt>>,                           false},
+                {"active-lpt",          make_engine<active_engine<dispatch::lpt>>,                           false},
+                {"active-mwkr",         make_engine<active_engine<dispatch::mwkr>>,                          false},
+                {"active-mopnr",        make_engine<active_engine<dispatch::mopnr>>,                         false},
+                {"active-fifo",         make_engine<active_engine<dispatch::fifo>>,                          false},
+                {"active-random",       make_engine<active_engine<dispatch::uniform, dispatch::random_tie>>, false},
+                {"shifting-bottleneck", make_engine<shifting_bottleneck_engine>,                             false}};
+        return registry;
+    }
+
+    std::unique_ptr<engine> create_engine(const std::string& name, const instance& data) {
+        for (const auto& entry : engine_registry()) {
+            if (name != entry.name) continue;
+            if (not entry.general and not data.classic())
+                throw std::invalid_argument("Engine " + name + " supports neither eligible machines nor downtimes");
+            return entry.create(data);
+        }
+        std::string known;
+        for (const auto& entry : engine_registry()) known += std::string(known.empty() ? "" : ", ") + entry.name;
+        throw std::invalid_argument("Unknown engine " + name + " (known engines: " + known + ")");
+    }
+}
+
+#endif //JOB_SHOP_ENGINES
@@ -0,0 +1,54 @@
+#ifndef JOB_SHOP_GENERATOR
+#define JOB_SHOP_GENERATOR
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "dataset.hpp"
+
+namespace js {
+
+    enum class duration_distribution { uniform, exponential };
+
+    duration_distribution parse_duration_distribution(const std::string& name) {
+        if (name == "uniform") return duration_distribution::uniform;
+        if (name == "exponential") return duration_distribution::exponential;
+        throw std::invalid_argument("Unknown duration distribution " + name + " (known: uniform, exponential)");
+    }
+
+    /**
+     * Random instance in the style of Taillard's generator: every job visits every machine once, in a random order,
+     * with durations in [min_duration, max_duration]. Uniform durations are Taillard's; exponential ones, with a
+     * mean a quarter of the range above the minimum, give many short tasks and a few long ones.
+     */
+    instance generate_instance(uint32_t seed, size_t jobs_count, size_t machines_count,
+                               time32_t min_duration = 1, time32_t max_duration = 99,
+                               duration_distribution distribution = duration_distribution::uniform) {
+        if (min_duration > max_duration) throw std::invalid_argument("Minimum duration above the maximum");
+        instance data;
+        data.jobs_count = jobs_count;
+        data.machines_count = machines_count;
+        data.machines.resize(data.tasks_count());
+        data.durations.resize(data.tasks_count());
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<time32_t> uniform(min_duration, max_duration);
+        std::exponential_distribution<double> exponential(4.0 / std::max(double(max_duration - min_duration), 1.0));
+        const auto duration = [&] {
+            if (distribution == duration_distribution::uniform) return uniform(random);
+            return time32_t(std::min(double(min_duration) + std::floor(exponential(random)), double(max_duration)));
+        };
+        for (size_t job = 0; job < jobs_count; job++) {
+            const auto first = data.machines.begin() + std::ptrdiff_t(data.index(job, 0));
+            std::iota(first, first + std::ptrdiff_t(machines_count), 0);
+            std::shuffle(first, first + std::ptrdiff_t(machines_count), random);
+            for (size_t i = 0; i < machines_count; i++) data.durations[data.index(job, i)] = duration();
+        }
+        return data;
+    }
+}
+
+#endif //JOB_SHOP_GENERATOR
@@ -0,0 +1,199 @@
+#ifndef JOB_SHOP_GIFFLER_THOMPSON
+#define JOB_SHOP_GIFFLER_THOMPSON
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "dataset.hpp"
+#include "schedule.hpp"
+
+namespace js {
+
+    namespace dispatch {
+
+        struct operation_view {
+            id32_t job;
+            size_t operation, remaining_operations;
+            time32_t duration, release, remaining_work;
+        };
+
+        struct spt {
+            static int64_t priority(const operation_view& op) { return op.duration; }
+        };
+
+        struct lpt {
+            static int64_t priority(const operation_view& op) { return -int64_t(op.duration); }
+        };
+
+        struct mwkr {
+            static int64_t priority(const operation_view& op) { return -int64_t(op.remaining_work); }
+        };
+
+        struct mopnr {
+            static int64_t priority(const operation_view& op) { return -int64_t(op.remaining_operations); }
+        };
+
+        struct fifo {
+            static int64_t priority(const operation_view& op) { return op.release; }
+        };
+
+        /** Ties every operation, leaving the whole choice to the tie break. */
+        struct uniform {
+            static int64_t priority(const operation_view& op) { return 0; }
+        };
+
+        struct lowest_id {
+            bool prefer(id32_t candidate, id32_t incumbent, size_t ties) { return candidate < incumbent; }
+        };
+
+        class random_tie {
+
+            std::mt19937 random;
+
+        public:
+
+            random_tie() : random(0) {}
+
+            explicit random_tie(uint32_t seed) : random(seed) {}
+
+            void seed(uint32_t seed) { random.seed(seed); }
+
+            bool prefer(id32_t candidate, id32_t incumbent, size_t ties) {
+                return std::uniform_int_distribution<size_t>(0, ties - 1)(random) == 0;
+            }
+        };
+    }
+
+    /**
+     * Giffler-Thompson active schedule generator. The operation with the earliest completion time fixes the
+     * machine; among the operations on that machine that could start before this completion time, the one with
+     * the lowest priority value of <code>Rule</code> is scheduled, ties resolved by <code>TieBreak</code>.
+     * The earliest completion time of each machine is kept in a lazy min-heap invalidated by per-machine versions.
+     * The conflict set is a linear scan of the operations waiting for the machine: they are few, and nearly all of
+     * them start before the earliest completion, so ordering them by start would not shorten the scan.
+     */
+    template<typename Rule, typename TieBreak = dispatch::lowest_id>
+    class giffler_thompson {
+
+        struct entry {
+            time32_t completion;
+            id32_t machine;
+            uint32_t version;
+
+            bool operator>(const entry& other) const {
+                return completion > other.completion;
+            }
+        };
+
+        const instance& data;
+        std::vector<uint32_t> next_operation, versions;
+        std::vector<time32_t> releases, remaining_work, machine_ready, machine_completion;
+        std::vector<std::vector<id32_t>> waiting;
+        std::vector<entry> heap;
+
+        [[nodiscard]] time32_t start_of(id32_t job, id32_t machine) const {
+            return std::max(releases[job], machine_ready[machine]);
+        }
+
+        [[nodiscard]] time32_t completion_of(id32_t job, id32_t machine) const {
+            return start_of(job, machine) + data.duration(job, next_operation[job]);
+        }
+
+        void push(id32_t machine) {
+            heap.push_back({machine_completion[machine], machine, ++versions[machine]});
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        }
+
+        void refresh(id32_t machine) {
+            machine_completion[machine] = interval::infinity;
+            for (const id32_t job : waiting[machine])
+                machine_completion[machine] = std::min(machine_completion[machine], completion_of(job, machine));
+            if (not waiting[machine].empty()) push(machine);
+        }
+
+        void arrive(id32_t job) {
+            const id32_t machine = data.machine(job, next_operation[job]);
+            waiting[machine].push_back(job);
+            const time32_t completion = completion_of(job, machine);
+            if (completion < machine_completion[machine]) {
+                machine_completion[machine] = completion;
+                push(machine);
+            }
+        }
+
+        [[nodiscard]] dispatch::operation_view view(id32_t job) const {
+            const size_t operation = next_operation[job];
+            return {job, operation, data.machines_count - operation, data.duration(job, operation), releases[job],
+                    remaining_work[job]};
+        }
+
+    public:
+
+        TieBreak tie_break;
+
+        explicit giffler_thompson(const instance& data, TieBreak tie_break = {})
+                : data(data), next_operation(data.jobs_count), versions(data.machines_count),
+                  releases(data.jobs_count), remaining_work(data.jobs_count), machine_ready(data.machines_count),
+                  machine_completion(data.machines_count), waiting(data.machines_count),
+                  tie_break(std::move(tie_break)) {
+            for (auto& jobs : waiting) jobs.reserve(data.jobs_count);
+            heap.reserve(2 * data.tasks_count() + data.machines_count);
+        }
+
+        /** Builds the schedule; returns false, leaving it incomplete, if <code>stop</code> cut it short. */
+        bool schedule_into(schedule& schedule, const stop_predicate& stop = {}) {
+            schedule.reset();
+            if (data.machines_count == 0) return true;
+            std::fill(next_operation.begin(), next_operation.end(), 0);
+            std::fill(releases.begin(), releases.end(), 0);
+            std::fill(machine_ready.begin(), machine_ready.end(), 0);
+            std::fill(machine_completion.begin(), machine_completion.end(), interval::infinity);
+            for (auto& jobs : waiting) jobs.clear();
+            heap.clear();
+            for (id32_t job = 0; job < id32_t(data.jobs_count); job++) {
+                remaining_work[job] = 0;
+                for (size_t i = 0; i < data.machines_count; i++) remaining_work[job] += data.duration(job, i);
+                arrive(job);
+            }
+
+            while (not heap.empty()) {
+                if (stop and stop()) return false;
+                std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+                const entry top = heap.back();
+                heap.pop_back();
+                const id32_t machine = top.machine;
+                if (versions[machine] != top.version) continue;
+
+                auto& candidates = waiting[machine];
+                size_t chosen = candidates.size(), ties = 0;
+                int64_t best_priority = 0;
+                for (size_t i = 0; i < candidates.size(); i++) {
+                    const id32_t job = candidates[i];
+                    const time32_t start = start_of(job, machine);
+                    if (start >= top.completion and completion_of(job, machine) != top.completion) continue;
+                    const int64_t priority = Rule::priority(view(job));
+                    if (chosen == candidates.size() or priority < best_priority) {
+                        chosen = i, best_priority = priority, ties = 1;
+                    } else if (priority == best_priority and tie_break.prefer(job, candidates[chosen], ++ties)) {
+                        chosen = i;
+                    }
+                }
+                const id32_t job = candidates[chosen];
+                candidates[chosen] = candidates.back();
+                candidates.pop_back();
+
+                const size_t operation = next_operation[job];
+                const time32_t start = start_of(job, machine), duration = data.duration(job, operation);
+                schedule.place_task(job, operation, start);
+                releases[job] = machine_ready[machine] = start + duration;
+                remaining_work[job] -= duration;
+                refresh(machine);
+                if (++next_operation[job] < data.machines_count) arrive(job);
+            }
+            return true;
+        }
+    };
+}
+
+#endif //JOB_SHOP_GIFFLER_THOMPSON
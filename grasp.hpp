@@ -0,0 +1,170 @@
+#ifndef JOB_SHOP_GRASP
+#define JOB_SHOP_GRASP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include "dataset.hpp"
+#include "heuristics.hpp"
+#include "instrumentation.hpp"
+#include "schedule.hpp"
+#include "thread_pool.hpp"
+#include "timer.hpp"
+
+namespace js {
+
+    /**
+     * SplitMix64 generator. Its state is a single word, so every start of a multi-start search can own an
+     * independent stream derived from the seed and the start index.
+     */
+    class splitmix64 {
+
+        uint64_t state;
+
+    public:
+
+        typedef uint64_t result_type;
+
+        explicit splitmix64(uint64_t seed) : state(seed) {}
+
+        static uint64_t mix(uint64_t value) {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+
+        static constexpr uint64_t min() { return 0; }
+
+        static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+        uint64_t operator()() {
+            return mix(state += 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    /**
+     * Randomized greedy order: every position of a round is filled with a random one of the next
+     * <code>size</code> jobs of the heuristic order (the restricted candidate list).
+     */
+    template<typename Random>
+    struct restricted_candidates {
+
+        Random& random;
+        size_t size;
+
+        void operator()(std::vector<id32_t>& order) const {
+            for (size_t i = 0; i + 1 < order.size(); i++) {
+                const size_t last = std::min(i + size, order.size()) - 1;
+                const size_t chosen = i + std::uniform_int_distribution<size_t>(0, last - i)(random);
+                std::rotate(order.begin() + ptrdiff_t(i), order.begin() + ptrdiff_t(chosen),
+                            order.begin() + ptrdiff_t(chosen) + 1);
+            }
+        }
+    };
+
+    template<round_heuristic Heuristic, typename Perturbation>
+    void restart_list_heuristic(schedule& schedule, const Perturbation& perturb) {
+        schedule.reset();
+        schedule.schedule_jobs<Heuristic>(perturb);
+    }
+
+    /** The list heuristics that randomized restarts cycle through. */
+    template<typename Perturbation>
+    constexpr std::array<void (*)(schedule&, const Perturbation&), 4> list_restarts = {
+            restart_list_heuristic<heuristics::pass, Perturbation>,
+            restart_list_heuristic<heuristics::reversed, Perturbation>,
+            restart_list_heuristic<heuristics::stachu_ascending, Perturbation>,
+            restart_list_heuristic<heuristics::stachu_descending, Perturbation>};
+
+    /**
+     * Greedy randomized adaptive search: builds many list schedules with restricted candidate lists, spread over the
+     * pool. Start <code>k</code> draws from its own stream seeded by <code>(seed, k)</code> and the best schedule is
+     * the one with the smallest <code>(makespan, k)</code>, so the result depends on the seed only, not on the
+     * threads. Workers keep their schedule and best solution between starts, so a start does not allocate.
+     */
+    class grasp {
+
+        struct worker {
+            schedule current;
+            solution_state best;
+            time32_t best_makespan = std::numeric_limits<time32_t>::max();
+            uint64_t best_start = 0;
+
+            explicit worker(const instance& data) : current(data), best(data) {}
+        };
+
+        typedef restricted_candidates<splitmix64> perturbation;
+
+        const instance& data;
+        std::vector<worker> workers;
+        std::atomic<time32_t> best_makespan = std::numeric_limits<time32_t>::max();
+        const worker* winner = nullptr;
+
+    public:
+
+        static constexpr size_t default_candidates = 5;
+
+        explicit grasp(const instance& data) : data(data) {}
+
+        /**
+         * Runs starts <code>0</code> to <code>starts - 1</code>, unless the target makespan is reached, the time
+         * limit expires or a stop is requested, and returns the best makespan found.
+         */
+        time32_t run(thread_pool& pool, uint64_t starts, uint64_t seed, time32_t target = 0,
+                     uint64_t time_limit_us = std::numeric_limits<uint64_t>::max(),
+                     const std::atomic<bool>* stop = nullptr, size_t candidates = default_candidates) {
+            timer<precision::us> clock;
+            clock.start();
+            const size_t streams = std::max<size_t>(pool.size(), 1);
+            workers.reserve(streams);
+            while (workers.size() < streams) workers.emplace_back(data);
+            best_makespan = std::numeric_limits<time32_t>::max();
+
+            for (size_t w = 0; w < streams; w++)
+                pool.submit([&, w] {
+                    JS_HEURISTIC("grasp");
+                    JS_SCOPE("grasp_worker");
+                    worker& self = workers[w];
+                    self.best_makespan = std::numeric_limits<time32_t>::max();
+                    for (uint64_t k = w; k < starts; k += streams) {
+                        if (best_makespan.load(std::memory_order_relaxed) <= target
+                            or (stop != nullptr and stop->load(std::memory_order_relaxed))
+                            or uint64_t(clock.get_elapsed_time()) >= time_limit_us)
+                            break;
+                        splitmix64 random(splitmix64::mix(seed) ^ splitmix64::mix(k + 1));
+                        const perturbation perturb{random, candidates};
+                        list_restarts<perturbation>[k % list_restarts<perturbation>.size()](self.current, perturb);
+                        const time32_t makespan = self.current.longest_timeline();
+                        time32_t global = best_makespan.load(std::memory_order_relaxed);
+                        if (makespan >= self.best_makespan or makespan > global) continue;
+                        self.best = self.current.solution();
+                        self.best_makespan = makespan;
+                        self.best_start = k;
+                        while (makespan < global and not best_makespan.compare_exchange_weak(global, makespan));
+                    }
+                });
+            pool.wait();
+
+            winner = nullptr;
+            for (size_t w = 0; w < streams; w++) {
+                const worker& candidate = workers[w];
+                if (candidate.best_makespan != std::numeric_limits<time32_t>::max()
+                    and (winner == nullptr or std::tie(candidate.best_makespan, candidate.best_start)
+                                              < std::tie(winner->best_makespan, winner->best_start)))
+                    winner = &candidate;
+            }
+            return winner == nullptr ? std::numeric_limits<time32_t>::max() : winner->best_makespan;
+        }
+
+        /** Solution of the best start of the last run; only valid if that run completed at least one start. */
+        [[nodiscard]] const solution_state& best_solution() const {
+            return winner->best;
+        }
+    };
+}
+
+#endif //JOB_SHOP_GRASP
@@ -1,28 +1,90 @@
 #ifndef JOB_SHOP_HEURISTICS
 #define JOB_SHOP_HEURISTICS
 
-#include <functional>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <random>
 #include <utility>
+#include <vector>
 #include "dataset.hpp"
+#include "instrumentation.hpp"
 
 namespace js {
 
     enum heuristic_mod { do_nothing, reverse, sort };
 
-    typedef std::pair<heuristic_mod, std::function<bool(const js::job*, const js::job*, size_t)>> heuristic;
+    /**
+     * Job ordering used by the round-robin list scheduler. Heuristics with the <code>sort</code> mode order the jobs
+     * of every round by an integer key computed once per job, smaller keys first.
+     */
+    template<typename H>
+    concept round_heuristic = requires(const instance& data, id32_t job, size_t i) {
+        { H::mode } -> std::convertible_to<heuristic_mod>;
+        { H::key(data, job, i) } -> std::same_as<uint32_t>;
+    };
 
     namespace heuristics {
 
-        bool pass(const js::job* a, const js::job* b, size_t i) {
-            return false;
-        }
+        struct pass {
+            static constexpr heuristic_mod mode = do_nothing;
+            static uint32_t key(const instance& data, id32_t job, size_t i) { return 0; }
+        };
+
+        struct reversed {
+            static constexpr heuristic_mod mode = reverse;
+            static uint32_t key(const instance& data, id32_t job, size_t i) { return 0; }
+        };
+
+        struct stachu_ascending {
+            static constexpr heuristic_mod mode = sort;
+            static uint32_t key(const instance& data, id32_t job, size_t i) { return data.duration(job, i); }
+        };
+
+        struct stachu_descending {
+            static constexpr heuristic_mod mode = sort;
+            static uint32_t key(const instance& data, id32_t job, size_t i) { return ~data.duration(job, i); }
+        };
+    }
+
+    struct no_perturbation {
+        void operator()(std::vector<id32_t>& order) const {}
+    };
+
+    /** Perturbs the job order of every round with random swaps of neighbouring jobs. */
+    template<typename Random>
+    struct random_swaps {
+
+        Random& random;
+        size_t swaps;
 
-        bool stachu_ascending(const js::job* a, const js::job* b, size_t i) {
-            return a->sequence[i].duration < b->sequence[i].duration;
+        void operator()(std::vector<id32_t>& order) const {
+            if (order.size() < 2) return;
+            std::uniform_int_distribution<size_t> position(0, order.size() - 2);
+            for (size_t i = 0; i < swaps; i++) {
+                const size_t first = position(random);
+                std::swap(order[first], order[first + 1]);
+            }
         }
+    };
 
-        bool stachu_descending(const js::job* a, const js::job* b, size_t i) {
-            return a->sequence[i].duration > b->sequence[i].duration;
+    /**
+     * Stable LSD radix sort of <code>order</code> by <code>keys</code> (indexed by the values in
+     * <code>order</code>), using 8-bit digits and skipping the digits above the largest differing bit.
+     */
+    void sort_by_key(std::vector<id32_t>& order, const std::vector<uint32_t>& keys, std::vector<id32_t>& scratch) {
+        uint32_t any_set = 0, all_set = ~0u;
+        for (const id32_t item : order) any_set |= keys[item], all_set &= keys[item];
+        const uint32_t varying = any_set ^ all_set;
+        scratch.resize(order.size());
+        for (uint32_t shift = 0; shift < 32 and (varying >> shift) != 0; shift += 8) {
+            if (((varying >> shift) & 0xFF) == 0) continue;
+            JS_COUNT_AT(radix_passes, js::trace::no_machine);
+            std::array<size_t, 257> offsets{};
+            for (const id32_t item : order) offsets[((keys[item] >> shift) & 0xFF) + 1]++;
+            for (size_t digit = 1; digit < offsets.size(); digit++) offsets[digit] += offsets[digit - 1];
+            for (const id32_t item : order) scratch[offsets[(keys[item] >> shift) & 0xFF]++] = item;
+            order.swap(scratch);
         }
     }
 }
@@ -0,0 +1,345 @@
+#ifndef JOB_SHOP_INCREMENTAL
+#define JOB_SHOP_INCREMENTAL
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "dataset.hpp"
+#include "schedule.hpp"
+
+namespace js {
+
+    struct task_change {
+        id32_t job;
+        uint32_t operation;
+        time32_t start;
+    };
+
+    struct what_if_result {
+        time32_t makespan = 0;
+        std::vector<task_change> changed;
+    };
+
+    /**
+     * Copy of a schedule that answers what-if queries: the order of the tasks on every machine is kept and the start
+     * times are repropagated (each task starts as soon as its job and machine predecessors end and its machine is
+     * available) only from the tasks a change touches. Queries are cumulative; each returns the new makespan and
+     * the tasks whose start time changed.
+     *
+     * Starts and ends never decrease along a machine sequence and the unavailabilities of a machine are kept merged
+     * and sorted, so queries find their first task and interval by binary search.
+     */
+    class incremental_schedule {
+
+        typedef uint32_t node32_t;
+        static constexpr node32_t none = std::numeric_limits<node32_t>::max();
+
+        size_t machines_count, jobs_count;
+        std::vector<id32_t> machines;
+        std::vector<time32_t> durations, starts;
+        std::vector<node32_t> machine_prev, machine_next;
+        std::vector<std::vector<node32_t>> sequences;
+        std::vector<uint32_t> positions;
+        std::vector<uint8_t> removed, queued, touched;
+        std::vector<std::pair<node32_t, time32_t>> previous_starts;
+        std::vector<std::vector<std::pair<time32_t, time32_t>>> unavailable;
+        std::vector<time32_t> job_ends;
+        size_t ends_capacity = 1;
+        std::vector<std::pair<time32_t, node32_t>> pending;
+        what_if_result result;
+
+        [[nodiscard]] node32_t job_prev(node32_t node) const {
+            return node % machines_count == 0 ? none : node - 1;
+        }
+
+        [[nodiscard]] node32_t job_next(node32_t node) const {
+            return (node + 1) % machines_count == 0 ? none : node + 1;
+        }
+
+        [[nodiscard]] time32_t end_of(node32_t node) const {
+            return node == none ? 0 : starts[node] + durations[node];
+        }
+
+        /** Position of the first task of the machine that still runs at <code>time</code>. */
+        [[nodiscard]] size_t first_running(id32_t machine, time32_t time) const {
+            const auto& sequence = sequences[machine];
+            return std::partition_point(sequence.begin(), sequence.end(), [&](node32_t node) {
+                return starts[node] + std::max<time32_t>(durations[node], 1) <= time;
+            }) - sequence.begin();
+        }
+
+        /** Earliest start at or after <code>from</code> at which the task does not overlap an unavailability. */
+        [[nodiscard]] time32_t available_start(id32_t machine, time32_t from, time32_t duration) const {
+            const auto& intervals = unavailable[machine];
+            auto interval = std::partition_point(intervals.begin(), intervals.end(),
+                                                 [&](const auto& range) { return range.second <= from; });
+            for (; interval != intervals.end() and interval->first < from + std::max<time32_t>(duration, 1); ++interval)
+                from = interval->second;
+            return from;
+        }
+
+        /**
+         * Adds <code>[from, to)</code> to the unavailabilities of a machine, merged with those it overlaps or
+         * touches.
+         */
+        void add_unavailability(id32_t machine, time32_t from, time32_t to) {
+            auto& intervals = unavailable[machine];
+            auto first = std::partition_point(intervals.begin(), intervals.end(),
+                                              [&](const auto& range) { return range.second < from; });
+            const auto last = std::partition_point(first, intervals.end(),
+                                                   [&](const auto& range) { return range.first <= to; });
+            if (first != last) {
+                from = std::min(from, first->first);
+                to = std::max(to, std::prev(last)->second);
+                first = intervals.erase(first, last);
+            }
+            intervals.emplace(first, from, to);
+        }
+
+        /** Job ends are kept in a max segment tree, so the makespan follows every change in logarithmic time. */
+        void update_job_end(size_t job, time32_t end) {
+            size_t position = ends_capacity + job;
+            job_ends[position] = end;
+            for (position /= 2; position > 0; position /= 2)
+                job_ends[position] = std::max(job_ends[2 * position], job_ends[2 * position + 1]);
+        }
+
+        void rebuild_job_ends() {
+            while (ends_capacity < jobs_count) ends_capacity *= 2;
+            job_ends.assign(2 * ends_capacity, 0);
+            for (size_t job = 0; job < jobs_count; job++)
+                if (not removed[job]) job_ends[ends_capacity + job] = end_of(node32_t((job + 1) * machines_count - 1));
+            for (size_t position = ends_capacity - 1; position > 0; position--)
+                job_ends[position] = std::max(job_ends[2 * position], job_ends[2 * position + 1]);
+        }
+
+        void push(node32_t node) {
+            if (node == none or queued[node] or removed[node / machines_count]) return;
+            queued[node] = true;
+            pending.emplace_back(starts[node], node);
+            std::push_heap(pending.begin(), pending.end(), std::greater<>());
+        }
+
+        void push_successors(node32_t node) {
+            push(job_next(node));
+            push(machine_next[node]);
+        }
+
+        void set_start(node32_t node, time32_t start) {
+            if (not touched[node]) {
+                touched[node] = true;
+                previous_starts.emplace_back(node, starts[node]);
+            }
+            starts[node] = start;
+        }
+
+        void propagate() {
+            while (not pending.empty()) {
+                std::pop_heap(pending.begin(), pending.end(), std::greater<>());
+                const node32_t node = pending.back().second;
+                pending.pop_back();
+                queued[node] = false;
+                const time32_t start = available_start(machines[node], std::max(end_of(job_prev(node)),
+                                                                                end_of(machine_prev[node])),
+                                                       durations[node]);
+                if (start == starts[node]) continue;
+                set_start(node, start);
+                if (job_next(node) == none) update_job_end(node / machines_count, end_of(node));
+                push_successors(node);
+            }
+        }
+
+        what_if_result& finish() {
+            propagate();
+            result.changed.clear();
+            for (const auto& [node, previous] : previous_starts) {
+                touched[node] = false;
+                if (starts[node] != previous or removed[node / machines_count])
+                    result.changed.push_back({id32_t(node / machines_count), uint32_t(node % machines_count),
+                                              starts[node]});
+            }
+            previous_starts.clear();
+            result.makespan = makespan();
+            return result;
+        }
+
+        void check_task(size_t job, size_t operation) const {
+            if (job >= jobs_count or operation >= machines_count or removed[job])
+                throw std::out_of_range("No task " + std::to_string(operation) + " in job " + std::to_string(job));
+        }
+
+        /** Links the machine sequence of a node, whose position in it is already set, to its neighbours. */
+        void link(node32_t node) {
+            const auto& sequence = sequences[machines[node]];
+            const uint32_t position = positions[node];
+            machine_prev[node] = position == 0 ? none : sequence[position - 1];
+            machine_next[node] = position + 1 == sequence.size() ? none : sequence[position + 1];
+            if (machine_prev[node] != none) machine_next[machine_prev[node]] = node;
+            if (machine_next[node] != none) machine_prev[machine_next[node]] = node;
+        }
+
+        void link_at(node32_t node, size_t position) {
+            auto& sequence = sequences[machines[node]];
+            sequence.insert(sequence.begin() + std::ptrdiff_t(position), node);
+            for (size_t next = position; next < sequence.size(); next++) positions[sequence[next]] = uint32_t(next);
+            link(node);
+        }
+
+        void unlink(node32_t node) {
+            const node32_t previous = machine_prev[node], next = machine_next[node];
+            if (previous != none) machine_next[previous] = next;
+            if (next != none) machine_prev[next] = previous;
+            machine_prev[node] = machine_next[node] = none;
+            auto& sequence = sequences[machines[node]];
+            sequence.erase(sequence.begin() + positions[node]);
+            for (size_t position = positions[node]; position < sequence.size(); position++)
+                positions[sequence[position]] = uint32_t(position);
+        }
+
+    public:
+
+        explicit incremental_schedule(const schedule& schedule)
+                : machines_count(schedule.problem().machines_count), jobs_count(schedule.problem().jobs_count),
+                  machines(schedule.solution().assigned_machines.empty() ? schedule.problem().machines
+                                                                         : schedule.solution().assigned_machines),
+                  durations(schedule.problem().durations),
+                  starts(schedule.solution().scheduled_times), machine_prev(starts.size(), none),
+                  machine_next(starts.size(), none), sequences(machines_count), positions(starts.size()),
+                  removed(jobs_count), queued(starts.size()), touched(starts.size()), unavailable(machines_count) {
+            pending.reserve(starts.size());
+            previous_starts.reserve(starts.size());
+            result.changed.reserve(starts.size());
+            std::vector<node32_t> order(starts.size());
+            for (node32_t node = 0; node < order.size(); node++) order[node] = node;
+            std::sort(order.begin(), order.end(), [&](node32_t a, node32_t b) {
+                return std::tuple(machines[a], starts[a], end_of(a), a)
+                       < std::tuple(machines[b], starts[b], end_of(b), b);
+            });
+            for (const node32_t node : order) {
+                positions[node] = uint32_t(sequences[machines[node]].size());
+                sequences[machines[node]].push_back(node);
+                link(node);
+            }
+            for (const auto& downtime : schedule.problem().downtimes)
+                add_unavailability(downtime.machine, downtime.start, downtime.end);
+            rebuild_job_ends();
+        }
+
+        [[nodiscard]] time32_t makespan() const {
+            return job_ends[1];
+        }
+
+        [[nodiscard]] size_t jobs() const {
+            return jobs_count;
+        }
+
+        [[nodiscard]] bool contains(size_t job) const {
+            return job < jobs_count and not removed[job];
+        }
+
+        [[nodiscard]] time32_t start(size_t job, size_t operation) const {
+            return starts[job * machines_count + operation];
+        }
+
+        [[nodiscard]] time32_t duration(size_t job, size_t operation) const {
+            return durations[job * machines_count + operation];
+        }
+
+        [[nodiscard]] id32_t machine(size_t job, size_t operation) const {
+            return machines[job * machines_count + operation];
+        }
+
+        const what_if_result& change_duration(size_t job, size_t operation, time32_t duration) {
+            check_task(job, operation);
+            const auto node = node32_t(job * machines_count + operation);
+            durations[node] = duration;
+            if (job_next(node) == none) update_job_end(job, end_of(node));
+            push(node);
+            push_successors(node);
+            return finish();
+        }
+
+        /** Makes a machine unavailable in <code>[from, to)</code>; tasks overlapping it are delayed past it. */
+        const what_if_result& block_machine(id32_t machine, time32_t from, time32_t to) {
+            if (machine < 0 or size_t(machine) >= machines_count)
+                throw std::out_of_range("No machine " + std::to_string(machine));
+            if (from >= to) return finish();
+            add_unavailability(machine, from, to);
+            const auto& sequence = sequences[machine];
+            for (size_t position = first_running(machine, from); position < sequence.size(); position++) {
+                if (starts[sequence[position]] >= to) break;
+                push(sequence[position]);
+            }
+            return finish();
+        }
+
+        /**
+         * Adds a job given as <code>(machine, duration)</code> pairs, one per machine count, and inserts each of its
+         * tasks into the earliest gap of its machine; the other tasks do not move.
+         */
+        const what_if_result& add_job(const std::vector<std::pair<id32_t, time32_t>>& operations) {
+            if (operations.size() != machines_count)
+                throw std::invalid_argument("A job needs " + std::to_string(machines_count) + " operations");
+            for (const auto& [machine, duration] : operations)
+                if (machine < 0 or size_t(machine) >= machines_count)
+                    throw std::out_of_range("No machine " + std::to_string(machine));
+            const auto first = node32_t(starts.size());
+            for (const auto& [machine, duration] : operations) {
+                machines.push_back(machine);
+                durations.push_back(duration);
+            }
+            starts.resize(machines.size(), std::numeric_limits<time32_t>::max());
+            machine_prev.resize(machines.size(), none);
+            machine_next.resize(machines.size(), none);
+            positions.resize(machines.size());
+            queued.resize(machines.size());
+            touched.resize(machines.size());
+            removed.push_back(false);
+            jobs_count++;
+
+            time32_t ready = 0;
+            for (node32_t node = first; node < machines.size(); node++) {
+                const id32_t machine = machines[node];
+                const auto& sequence = sequences[machine];
+                size_t position = first_running(machine, ready);
+                time32_t start = available_start(machine, ready, durations[node]);
+                for (; position < sequence.size(); position++) {
+                    const node32_t next = sequence[position];
+                    if (start + durations[node] <= starts[next]) break;
+                    start = available_start(machine, std::max(ready, end_of(next)), durations[node]);
+                }
+                link_at(node, position);
+                set_start(node, start);
+                ready = start + durations[node];
+            }
+            if (jobs_count > ends_capacity) rebuild_job_ends();
+            else update_job_end(jobs_count - 1, ready);
+            return finish();
+        }
+
+        /**
+         * Removes a job; the tasks that followed its tasks on their machines may start earlier. The removed tasks are
+         * reported as changed with their last start time.
+         */
+        const what_if_result& remove_job(size_t job) {
+            check_task(job, 0);
+            removed[job] = true;
+            update_job_end(job, 0);
+            for (auto node = node32_t(job * machines_count); node < (job + 1) * machines_count; node++) {
+                const node32_t next = machine_next[node];
+                unlink(node);
+                set_start(node, starts[node]);
+                push(next);
+            }
+            return finish();
+        }
+    };
+}
+
+#endif //JOB_SHOP_INCREMENTAL
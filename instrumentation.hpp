@@ -0,0 +1,266 @@
+#ifndef JOB_SHOP_INSTRUMENTATION
+#define JOB_SHOP_INSTRUMENTATION
+
+#ifdef JS_INSTRUMENTATION
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Hot-path counters and scoped timings, compiled in only with <code>JS_INSTRUMENTATION</code> defined (the CMake
+ * option <code>JOB_SHOP_INSTRUMENTATION</code> or <code>make INSTRUMENTATION=1</code>); otherwise every macro
+ * expands to nothing.
+ *
+ * <code>JS_HEURISTIC(name)</code> attributes the counters of the enclosing scope to a heuristic,
+ * <code>JS_MACHINE(id)</code> selects the machine that <code>JS_COUNT(counter)</code> increments for,
+ * <code>JS_COUNT_AT(counter, id)</code> names the machine explicitly and <code>JS_SCOPE(name)</code> records the
+ * duration of the enclosing scope. Every thread records into its own buffers, merged by the reports.
+ */
+namespace js::trace {
+
+    enum counter {
+        slot_lookups, slot_descents, gaps_skipped, gap_splits, gap_erases, tree_rebuilds, task_sorts, radix_passes,
+        counters_count
+    };
+
+    static constexpr std::array<const char*, counters_count> counter_names = {
+            "slot_lookups", "slot_descents", "gaps_skipped", "gap_splits", "gap_erases", "tree_rebuilds",
+            "task_sorts", "radix_passes"};
+
+    static constexpr size_t no_machine = SIZE_MAX;
+
+    typedef std::array<uint64_t, counters_count> counter_row;
+
+    /** Counters of one heuristic: the first row is not tied to a machine, row <code>m + 1</code> is machine m. */
+    typedef std::vector<counter_row> counter_table;
+
+    /** Timed scope; its name is interned, as the string it was recorded with may be gone by the export. */
+    struct event {
+        const std::string* name;
+        uint64_t start_ns, duration_ns;
+    };
+
+    struct thread_buffer {
+        size_t thread_id;
+        std::map<std::string, counter_table> heuristics;
+        std::vector<event> events;
+        counter_table* table = nullptr;
+        size_t machine = no_machine;
+    };
+
+    struct registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<thread_buffer>> threads;
+        std::set<std::string, std::less<>> names;
+        const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    };
+
+    registry& global() {
+        static registry instance;
+        return instance;
+    }
+
+    thread_buffer& local() {
+        thread_local thread_buffer* buffer = [] {
+            registry& all = global();
+            std::lock_guard lock(all.mutex);
+            all.threads.push_back(std::make_unique<thread_buffer>());
+            all.threads.back()->thread_id = all.threads.size();
+            all.threads.back()->table = &all.threads.back()->heuristics["(none)"];
+            return all.threads.back().get();
+        }();
+        return *buffer;
+    }
+
+    const std::string* intern(std::string_view name) {
+        registry& all = global();
+        std::lock_guard lock(all.mutex);
+        auto interned = all.names.find(name);
+        if (interned == all.names.end()) interned = all.names.emplace(name).first;
+        return &*interned;
+    }
+
+    uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                                    - global().origin).count();
+    }
+
+    void count(counter counter, size_t machine, uint64_t amount = 1) {
+        counter_table& table = *local().table;
+        const size_t row = machine == no_machine ? 0 : machine + 1;
+        if (row >= table.size()) table.resize(row + 1);
+        table[row][counter] += amount;
+    }
+
+    class heuristic_scope {
+
+        counter_table* previous;
+
+    public:
+
+        explicit heuristic_scope(const std::string& name) : previous(local().table) {
+            local().table = &local().heuristics[name];
+        }
+
+        heuristic_scope(const heuristic_scope&) = delete;
+
+        heuristic_scope& operator=(const heuristic_scope&) = delete;
+
+        ~heuristic_scope() {
+            local().table = previous;
+        }
+    };
+
+    class timed_scope {
+
+        const std::string* name;
+        const uint64_t start = now_ns();
+
+    public:
+
+        explicit timed_scope(std::string_view name) : name(intern(name)) {}
+
+        timed_scope(const timed_scope&) = delete;
+
+        timed_scope& operator=(const timed_scope&) = delete;
+
+        ~timed_scope() {
+            local().events.push_back({name, start, now_ns() - start});
+        }
+    };
+
+    /** Counters summed over threads per heuristic and machine, and per-name totals of the scoped timings. */
+    void write_report(std::ostream& output) {
+        registry& all = global();
+        std::lock_guard lock(all.mutex);
+        std::map<std::string, counter_table> merged;
+        std::map<std::string, std::pair<uint64_t, uint64_t>> scopes;
+        for (const auto& thread : all.threads) {
+            for (const auto& [name, table] : thread->heuristics) {
+                counter_table& target = merged[name];
+                if (target.size() < table.size()) target.resize(table.size());
+                for (size_t row = 0; row < table.size(); row++)
+                    for (size_t c = 0; c < counters_count; c++) target[row][c] += table[row][c];
+            }
+            for (const auto& event : thread->events) {
+                scopes[*event.name].first++;
+                scopes[*event.name].second += event.duration_ns;
+            }
+        }
+        output << std::left << std::setw(24) << "scope" << std::right << std::setw(10) << "calls" << std::setw(16)
+               << "total [us]" << '\n';
+        for (const auto& [name, totals] : scopes)
+            output << std::left << std::setw(24) << name << std::right << std::setw(10) << totals.first
+                   << std::setw(16) << totals.second / 1000 << '\n';
+        for (const auto& [name, table] : merged) {
+            if (table.empty()) continue;
+            output << '\n' << std::left << std::setw(24) << name << std::right;
+            for (const char* counter : counter_names) output << std::setw(15) << counter;
+            output << '\n';
+            counter_row total{};
+            for (size_t row = 0; row < table.size(); row++) {
+                output << std::left << std::setw(24) << (row == 0 ? "  -" : "  machine " + std::to_string(row - 1))
+                       << std::right;
+                for (size_t c = 0; c < counters_count; c++) {
+                    output << std::setw(15) << table[row][c];
+                    total[c] += table[row][c];
+                }
+                output << '\n';
+            }
+            output << std::left << std::setw(24) << "  total" << std::right;
+            for (const uint64_t value : total) output << std::setw(15) << value;
+            output << '\n';
+        }
+    }
+
+    /**
+     * Chrome <code>trace_event</code> JSON (chrome://tracing, Perfetto): a complete event per timed scope and, per
+     * heuristic, one counter event with its totals.
+     */
+    void write_chrome_trace(std::ostream& output) {
+        registry& all = global();
+        std::lock_guard lock(all.mutex);
+        output << "{\"traceEvents\": [";
+        const char* separator = "\n";
+        uint64_t end_ns = 0;
+        for (const auto& thread : all.threads)
+            for (const auto& event : thread->events) {
+                output << separator << std::fixed << std::setprecision(3) << "  {\"name\": \"" << *event.name
+                       << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->thread_id << ", \"ts\": "
+                       << double(event.start_ns) / 1000 << ", \"dur\": " << double(event.duration_ns) / 1000 << "}";
+                end_ns = std::max(end_ns, event.start_ns + event.duration_ns);
+                separator = ",\n";
+            }
+        std::map<std::string, counter_row> totals;
+        for (const auto& thread : all.threads)
+            for (const auto& [name, table] : thread->heuristics)
+                for (const auto& row : table)
+                    for (size_t c = 0; c < counters_count; c++) totals[name][c] += row[c];
+        for (const auto& [name, total] : totals) {
+            output << separator << "  {\"name\": \"" << name << "\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+                   << double(end_ns) / 1000 << ", \"args\": {";
+            for (size_t c = 0; c < counters_count; c++)
+                output << (c > 0 ? ", " : "") << '"' << counter_names[c] << "\": " << total[c];
+            output << "}}";
+            separator = ",\n";
+        }
+        output << "\n]}\n";
+    }
+
+    /** Writes the Chrome trace to a file and the text report to stderr when it goes out of scope. */
+    class exporter {
+
+        std::string path;
+
+    public:
+
+        explicit exporter(std::string path) : path(std::move(path)) {}
+
+        exporter(const exporter&) = delete;
+
+        exporter& operator=(const exporter&) = delete;
+
+        ~exporter() {
+            if (path.empty()) return;
+            std::ofstream output(path);
+            write_chrome_trace(output);
+            write_report(std::cerr);
+        }
+    };
+}
+
+#define JS_CONCAT_IMPL(a, b) a##b
+#define JS_CONCAT(a, b) JS_CONCAT_IMPL(a, b)
+#define JS_HEURISTIC(name) const js::trace::heuristic_scope JS_CONCAT(js_heuristic_, __LINE__)(name)
+#define JS_SCOPE(name) const js::trace::timed_scope JS_CONCAT(js_scope_, __LINE__)(name)
+#define JS_MACHINE(id) (js::trace::local().machine = size_t(id))
+#define JS_COUNT(counter) js::trace::count(js::trace::counter, js::trace::local().machine)
+#define JS_COUNT_AT(counter, id) js::trace::count(js::trace::counter, size_t(id))
+#define JS_ADD(counter, amount) js::trace::count(js::trace::counter, js::trace::local().machine, amount)
+
+#else
+
+#define JS_HEURISTIC(name)
+#define JS_SCOPE(name)
+#define JS_MACHINE(id)
+#define JS_COUNT(counter)
+#define JS_COUNT_AT(counter, id)
+#define JS_ADD(counter, amount)
+
+#endif
+
+#endif //JOB_SHOP_INSTRUMENTATION
@@ -1,65 +1,157 @@
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <optional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
-#include "heuristics.hpp"
+#include "batch.hpp"
+#include "cache.hpp"
+#include "instrumentation.hpp"
+#include "online.hpp"
+#include "output.hpp"
 #include "platform.hpp"
 #include "schedule.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
 #include "timer.hpp"
+#include "validator.hpp"
 
 // http://www.cs.put.poznan.pl/mdrozdowski/dyd/ok/index.html
 
 int main(int argc, char** argv) {
 
-    std::string data_path = "data.txt";
-    bool display_gantt_chart = false, measure_time = false;
+    std::string data_path = "data.txt", manifest_path, socket_path, trace_path, cache_path;
+    uintmax_t cache_size_mb = 64;
+    size_t online_machines = 0, online_history = js::online_schedule::default_history_limit;
+    bool display_gantt_chart = false, measure_time = false, verify = false, progress = false;
     std::string output_path;
-    uint16_t iterations = 1, limit = 0;
+    uint16_t iterations = 1;
+    js::time32_t gantt_scale = 1;
+    size_t threads_count = js::thread_pool::default_threads_count();
+    js::solver_options options;
 
     for (int i = 1; i < argc; i++) {
         if (std::string(argv[i]) == "-d") data_path = argv[++i];
-        if (std::string(argv[i]) == "-l") limit = std::stol(argv[++i]);
+        if (std::string(argv[i]) == "-m") manifest_path = argv[++i];
+        if (std::string(argv[i]) == "-l") options.limit = std::stol(argv[++i]);
         if (std::string(argv[i]) == "-g") display_gantt_chart = true;
+        if (std::string(argv[i]) == "--gantt-scale") gantt_scale = std::max(std::stoul(argv[++i]), 1ul);
         if (std::string(argv[i]) == "-o") output_path = argv[++i];
         if (std::string(argv[i]) == "-t") measure_time = true;
         if (std::string(argv[i]) == "-r") iterations = std::stol(argv[++i]);
+        if (std::string(argv[i]) == "-j") threads_count = std::stoul(argv[++i]);
+        if (std::string(argv[i]) == "-e") options.engine_names.emplace_back(argv[++i]);
+        if (std::string(argv[i]) == "--verify") verify = true;
+        if (std::string(argv[i]) == "--time-limit") options.time_limit = std::stoull(argv[++i]);
+        if (std::string(argv[i]) == "--deadline") options.deadline = std::stoull(argv[++i]);
+        if (std::string(argv[i]) == "--progress") progress = true;
+        if (std::string(argv[i]) == "--grasp") options.grasp_starts = std::stoull(argv[++i]);
+        if (std::string(argv[i]) == "--seed") options.seed = std::stoull(argv[++i]);
+        if (std::string(argv[i]) == "--exact") options.exact = true;
+        if (std::string(argv[i]) == "--node-limit") options.node_limit = std::stoull(argv[++i]);
+        if (std::string(argv[i]) == "--online") online_machines = std::stoul(argv[++i]);
+        if (std::string(argv[i]) == "--online-history") online_history = std::stoul(argv[++i]);
+        if (std::string(argv[i]) == "--socket") socket_path = argv[++i];
+        if (std::string(argv[i]) == "--trace") trace_path = argv[++i];
+        if (std::string(argv[i]) == "--cache") cache_path = argv[++i];
+        if (std::string(argv[i]) == "--cache-size") cache_size_mb = std::stoull(argv[++i]);
     }
 
-    std::ifstream data_file(data_path);
-    if (not data_file.is_open()) throw std::runtime_error("Could not open file " + data_path);
-    std::ostringstream buffer;
-    buffer << data_file.rdbuf();
-    std::string data_string = buffer.str();
+#ifdef JS_INSTRUMENTATION
+    const js::trace::exporter trace_exporter(trace_path);
+#else
+    if (not trace_path.empty()) std::cerr << "Built without instrumentation, --trace ignored" << std::endl;
+#endif
+
+    if (online_machines > 0) {
+        js::online_session session(online_machines, online_history);
+        std::string line;
+        if (socket_path.empty()) {
+            while (std::getline(std::cin, line)) std::cout << session.handle(line) << std::flush;
+        } else {
+            js::handle_stop_signals();
+            js::unix_socket_server server(socket_path);
+            while (server.read_line(line, js::stop_signal())) server.write(session.handle(line));
+        }
+        const js::latency_histogram& latency = session.latency();
+        std::cerr << latency.count() << " requests, latency p50 " << latency.percentile(0.5) << " us, p90 "
+                  << latency.percentile(0.9) << " us, p99 " << latency.percentile(0.99) << " us, max "
+                  << latency.max() << " us" << std::endl;
+        return 0;
+    }
+
+    js::handle_stop_signals();
+    options.stop = &js::stop_signal();
+    std::unique_ptr<js::solution_cache> cache;
+    if (not cache_path.empty()) {
+        cache = std::make_unique<js::solution_cache>(cache_path, cache_size_mb << 20);
+        options.cache = cache.get();
+    }
+    if (progress)
+        options.on_improvement = [](const std::string& instance, uint64_t time_us, js::time32_t makespan) {
+            static std::mutex progress_mutex;
+            std::lock_guard lock(progress_mutex);
+            if (not instance.empty()) std::cerr << instance << ' ';
+            std::cerr << time_us << ' ' << makespan << '\n';
+        };
+
+    if (not manifest_path.empty() or std::filesystem::is_directory(data_path)) {
+        js::thread_pool pool(threads_count > 1 ? threads_count : 0);
+        const auto results = js::solve_batch(js::list_instances(manifest_path.empty() ? data_path : manifest_path),
+                                             options, output_path, pool, std::cout, verify);
+        const bool all_valid = std::all_of(results.begin(), results.end(), [&](const js::batch_result& result) {
+            return not result.skipped and result.error.empty() and (not verify or result.verification == "OK");
+        });
+        return all_valid ? 0 : 1;
+    }
+
+    js::instance data;
+    {
+        JS_SCOPE("parse");
+        data.load_from_file(data_path, options.limit);
+    }
+
+    js::solver solver(data, options);
+    const size_t workers_count = options.grasp_starts > 0 or options.exact ? threads_count
+                                                          : std::min(threads_count, solver.engines_count());
+    js::thread_pool pool(workers_count > 1 ? workers_count : 0);
 
     js::timer<js::precision::us> timer;
     if (measure_time) timer.start();
 
     for (uint32_t it = 0; it < iterations; it++) {
 
-        struct {
-            js::basic_schedule schedule;
-            std::string summary;
-            std::optional<js::time32_t> time;
-        } solution;
+        const js::schedule& solution = solver.solve(pool);
 
-        const js::heuristic heuristics[] = {{js::do_nothing, js::heuristics::pass},
-                                            {js::reverse, js::heuristics::pass},
-                                            {js::sort, js::heuristics::stachu_ascending},
-                                            {js::sort, js::heuristics::stachu_descending}};
-
-        for (const auto& heuristic : heuristics) {
+        if (verify) {
+            const js::validation validation = js::validate(solution);
+            if (not validation) {
+                std::cerr << "Invalid schedule: " << validation.error << std::endl;
+                return 1;
+            }
+        }
 
-            js::dataset data;
-            data.load_from_memory(data_string, limit);
+        if (measure_time) {
+            const js::lower_bounds& bounds = solver.lower_bound();
+            std::cerr << "makespan " << solution.longest_timeline() << ", lower bound " << bounds.value()
+                      << " (machine load " << bounds.machine_load << ", job length " << bounds.job_length
+                      << ", one machine " << bounds.one_machine << "), gap " << bounds.gap(solution.longest_timeline())
+                      << "%" << std::endl;
+        }
 
-            js::schedule schedule(data);
-            schedule.schedule_jobs(heuristic);
+        if (measure_time and options.time_limit > 0) {
+            const auto& stats = solver.search_statistics();
+            std::cerr << "tabu search: " << stats.iterations << " iterations, " << stats.evaluated_moves
+                      << " moves (" << uint64_t(double(stats.evaluated_moves) * 1e6 / double(stats.elapsed_us + 1))
+                      << " moves/s)" << std::endl;
+        }
 
-            if (not solution.time.has_value() or schedule.longest_timeline() < solution.time) {
-                if (display_gantt_chart) solution.schedule = *dynamic_cast<js::basic_schedule*>(&schedule);
-                solution.summary = schedule.summary();
-                solution.time = schedule.longest_timeline();
-            }
+        if (options.exact) {
+            const auto& stats = solver.exact_search_statistics();
+            std::cerr << "makespan " << solution.longest_timeline()
+                      << (solver.proven_optimal() ? " is optimal" : " is not proven optimal") << " (branch and bound: "
+                      << stats.nodes << " nodes in " << stats.elapsed_us << " us)" << std::endl;
         }
 
         if (measure_time) {
@@ -67,14 +159,25 @@ int main(int argc, char** argv) {
             std::cout << timer.get_measured_time() << std::endl;
             timer.start();
         } else {
+            JS_SCOPE("output");
             if (not output_path.empty()) {
                 js::create_directory(output_path);
                 std::ofstream file_out(output_path);
-                file_out << solution.summary;
-                file_out.close();
-            } else std::cout << solution.summary;
-            if (display_gantt_chart) std::cout << std::endl << solution.schedule.gantt_chart() << std::endl;
+                js::output_sink sink(file_out);
+                solution.write_summary(sink);
+            } else {
+                js::output_sink sink(std::cout);
+                solution.write_summary(sink);
+            }
+            if (display_gantt_chart) {
+                js::output_sink sink(std::cout);
+                sink.put('\n');
+                solution.write_gantt_chart(sink, gantt_scale);
+                sink.put('\n');
+            }
         }
+
+        if (js::stop_signal()) break;
     }
 
     return 0;
@@ -0,0 +1,207 @@
+#ifndef JOB_SHOP_ONLINE
+#define JOB_SHOP_ONLINE
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "dataset.hpp"
+#include "output.hpp"
+#include "parser.hpp"
+#include "schedule.hpp"
+#include "timer.hpp"
+
+namespace js {
+
+    /**
+     * Fixed-size latency histogram: 16 linear sub-buckets per power of two of microseconds, so percentiles are
+     * within about 6% and memory does not grow with the number of samples.
+     */
+    class latency_histogram {
+
+        static constexpr size_t sub_buckets = 16;
+        std::array<uint64_t, 64 * sub_buckets> counts{};
+        uint64_t total = 0, maximum = 0;
+
+        static size_t bucket(uint64_t value) {
+            if (value < sub_buckets) return value;
+            const size_t exponent = std::bit_width(value) - 1;
+            return (exponent - 3) * sub_buckets + ((value >> (exponent - 4)) & (sub_buckets - 1));
+        }
+
+        static uint64_t lower_bound(size_t bucket) {
+            if (bucket < sub_buckets) return bucket;
+            const size_t exponent = bucket / sub_buckets + 3;
+            return (sub_buckets + bucket % sub_buckets) << (exponent - 4);
+        }
+
+    public:
+
+        void add(uint64_t value_us) {
+            counts[bucket(value_us)]++;
+            total++;
+            maximum = std::max(maximum, value_us);
+        }
+
+        [[nodiscard]] uint64_t count() const {
+            return total;
+        }
+
+        [[nodiscard]] uint64_t max() const {
+            return maximum;
+        }
+
+        [[nodiscard]] uint64_t percentile(double p) const {
+            const auto rank = uint64_t(p * double(total));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); i++)
+                if ((seen += counts[i]) > rank) return std::min(lower_bound(i), maximum);
+            return maximum;
+        }
+    };
+
+    /**
+     * Schedule that grows one job at a time: every task goes to the earliest fitting gap of its machine's timeline
+     * at or after its job's release, as <code>schedule::add_task</code> does. Every job moves the "now" horizon
+     * forward to its release or, if later, to the earliest free time over all machines, before which no task can be
+     * placed anymore. Every job also checks the next timeline in turn and, once it holds twice the intervals it kept
+     * after its last compaction, and at least twice <code>history_limit</code>, compacts it, so that no single job
+     * pays for compacting every machine.
+     *
+     * Compaction drops the history behind "now", which no task can use anymore, and, with a non-zero
+     * <code>history_limit</code>, also everything behind the <code>history_limit</code> most recent gaps and tasks
+     * of the timeline. That trades schedule quality for memory: the gaps dropped after "now" could still have taken
+     * a short task, which is then placed later. Without releases, holes no task fits in hold "now" back and a zero
+     * limit stores every gap since; on a stream of 20000 jobs on 10 machines with durations up to 99, the default
+     * limit stores about 50 times fewer intervals for a makespan about 2% longer.
+     */
+    class online_schedule : public basic_schedule {
+
+        time32_t now = 0;
+        size_t next_compaction = 0;
+        std::vector<size_t> retained;
+        std::vector<time32_t> starts;
+
+    public:
+
+        static constexpr size_t default_history_limit = 256;
+        const size_t history_limit;
+
+        explicit online_schedule(size_t machines_count, size_t history_limit = default_history_limit)
+                : basic_schedule(machines_count, 0), retained(machines_count, 0), history_limit(history_limit) {}
+
+        [[nodiscard]] size_t machines_count() const {
+            return table.size();
+        }
+
+        [[nodiscard]] size_t jobs_scheduled() const {
+            return jobs_count;
+        }
+
+        [[nodiscard]] time32_t horizon() const {
+            return now;
+        }
+
+        [[nodiscard]] size_t stored_intervals() const {
+            size_t count = 0;
+            for (const timeline& timeline : table) count += timeline.stored_intervals();
+            return count;
+        }
+
+        void advance(time32_t time) {
+            time32_t first_free = std::numeric_limits<time32_t>::max();
+            for (const timeline& timeline : table) first_free = std::min(first_free, timeline.first_free());
+            now = std::max({now, time, first_free});
+            timeline& timeline = table[next_compaction];
+            if (timeline.stored_intervals() > 2 * std::max(history_limit, retained[next_compaction])) {
+                JS_MACHINE(next_compaction);
+                timeline.compact(history_limit > 0 ? std::max(now, timeline.recent_history(history_limit)) : now);
+                retained[next_compaction] = timeline.stored_intervals();
+            }
+            next_compaction = (next_compaction + 1) % table.size();
+        }
+
+        /** Schedules a job given as <code>(machine, duration)</code> pairs and returns the start of every task. */
+        const std::vector<time32_t>& add_job(const std::vector<std::pair<id32_t, time32_t>>& operations,
+                                             time32_t release) {
+            for (const auto& [machine, duration] : operations)
+                if (machine < 0 or size_t(machine) >= table.size())
+                    throw std::out_of_range("No machine " + std::to_string(machine));
+            advance(release);
+            starts.clear();
+            time32_t ready = now;
+            for (const auto& [machine, duration] : operations) {
+                timeline& timeline = table[machine];
+                JS_MACHINE(machine);
+                const timeline::slot slot = timeline.earliest_slot(ready, duration);
+                timeline.occupy(slot, duration, id32_t(jobs_count));
+                starts.push_back(slot.start);
+                ready = slot.start + duration;
+            }
+            jobs_count++;
+            return starts;
+        }
+    };
+
+    /**
+     * Line protocol of the online mode. A request is a job in the ORLib pair format (<code>machine duration</code>
+     * pairs), optionally preceded by its release time; the response is the job id and the start of every task, or an
+     * error line. Blank lines and lines starting with <code>#</code> are ignored.
+     */
+    class online_session {
+
+        online_schedule schedule;
+        std::vector<uint64_t> tokens;
+        std::vector<std::pair<id32_t, time32_t>> operations;
+        std::string response;
+        output_sink sink{response};
+        latency_histogram latencies;
+
+    public:
+
+        explicit online_session(size_t machines_count, size_t history_limit = online_schedule::default_history_limit)
+                : schedule(machines_count, history_limit) {}
+
+        [[nodiscard]] const online_schedule& state() const {
+            return schedule;
+        }
+
+        [[nodiscard]] const latency_histogram& latency() const {
+            return latencies;
+        }
+
+        /** Handles one request line and returns the response, empty for ignored lines. */
+        std::string_view handle(std::string_view line) {
+            timer<precision::ns> clock;
+            clock.start();
+            response.clear();
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos or line.front() == '#') return response;
+            try {
+                tokens.clear();
+                for (scanner scanner(line); not scanner.at_end();) tokens.push_back(scanner.next<uint32_t>());
+                const bool released = tokens.size() % 2 == 1;
+                const time32_t release = released ? time32_t(tokens.front()) : schedule.horizon();
+                operations.clear();
+                for (size_t i = released; i + 1 < tokens.size(); i += 2)
+                    operations.emplace_back(id32_t(tokens[i]), time32_t(tokens[i + 1]));
+                const auto& starts = schedule.add_job(operations, release);
+                sink.put_number(schedule.jobs_scheduled() - 1);
+                for (const time32_t start : starts) sink.put(' ').put_number(start);
+            } catch (const std::exception& exception) {
+                sink.put("error: ").put(exception.what());
+            }
+            sink.put('\n').flush();
+            clock.stop();
+            latencies.add(uint64_t(clock.get_measured_time()) / 1000);
+            return response;
+        }
+    };
+}
+
+#endif //JOB_SHOP_ONLINE
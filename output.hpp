@@ -0,0 +1,87 @@
+#ifndef JOB_SHOP_OUTPUT
+#define JOB_SHOP_OUTPUT
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace js {
+
+    /**
+     * Buffered text writer targeting a stream or a string. Integers are formatted with std::to_chars straight into
+     * the buffer, so writing does not allocate (except for growing a string target).
+     */
+    class output_sink {
+
+        std::array<char, 1 << 16> buffer{};
+        size_t used = 0;
+        std::ostream* stream = nullptr;
+        std::string* target = nullptr;
+
+        void reserve(size_t length) {
+            if (used + length > buffer.size()) flush();
+        }
+
+    public:
+
+        explicit output_sink(std::ostream& stream) : stream(&stream) {}
+
+        explicit output_sink(std::string& target) : target(&target) {}
+
+        output_sink(const output_sink&) = delete;
+
+        output_sink& operator=(const output_sink&) = delete;
+
+        ~output_sink() {
+            flush();
+        }
+
+        void flush() {
+            if (stream != nullptr) stream->write(buffer.data(), std::streamsize(used));
+            else target->append(buffer.data(), used);
+            used = 0;
+        }
+
+        output_sink& put(char c) {
+            reserve(1);
+            buffer[used++] = c;
+            return *this;
+        }
+
+        output_sink& put(std::string_view text) {
+            if (text.size() > buffer.size()) {
+                flush();
+                if (stream != nullptr) stream->write(text.data(), std::streamsize(text.size()));
+                else target->append(text);
+                return *this;
+            }
+            reserve(text.size());
+            std::copy(text.begin(), text.end(), buffer.begin() + std::ptrdiff_t(used));
+            used += text.size();
+            return *this;
+        }
+
+        output_sink& repeat(char c, size_t count) {
+            for (size_t i = 0; i < count; i++) put(c);
+            return *this;
+        }
+
+        output_sink& put_number(uint64_t value, size_t width = 0, char fill = '0') {
+            std::array<char, 24> digits{};
+            const size_t length = std::to_chars(digits.begin(), digits.end(), value).ptr - digits.begin();
+            if (width > length) repeat(fill, width - length);
+            return put(std::string_view(digits.data(), length));
+        }
+    };
+
+    size_t digits_count(uint64_t value) {
+        size_t digits = 1;
+        while (value >= 10) value /= 10, digits++;
+        return digits;
+    }
+}
+
+#endif //JOB_SHOP_OUTPUT
@@ -0,0 +1,109 @@
+#ifndef JOB_SHOP_PARSER
+#define JOB_SHOP_PARSER
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace js {
+
+    class parse_error : public std::runtime_error {
+
+    public:
+
+        const size_t line, column;
+
+        parse_error(const std::string& message, size_t line, size_t column)
+                : std::runtime_error("Parse error at " + std::to_string(line) + ":" + std::to_string(column)
+                                     + ": " + message), line(line), column(column) {}
+    };
+
+    /**
+     * Whitespace-separated token scanner working directly on a memory buffer. Positions are only translated to
+     * line and column numbers when an error is reported.
+     */
+    class scanner {
+
+        const char* const begin, * const end;
+        const char* cursor;
+
+        static bool is_space(char c) {
+            return c == ' ' or uint8_t(c - '\t') <= '\r' - '\t';
+        }
+
+        static bool is_digit(char c) {
+            return uint8_t(c - '0') < 10;
+        }
+
+        void skip_whitespace() {
+            while (cursor < end and is_space(*cursor)) ++cursor;
+        }
+
+    public:
+
+        explicit scanner(std::string_view data) : begin(data.data()), end(data.data() + data.size()), cursor(begin) {}
+
+        [[nodiscard]] bool at_end() {
+            skip_whitespace();
+            return cursor == end;
+        }
+
+        [[nodiscard]] size_t position() const {
+            return cursor - begin;
+        }
+
+        [[noreturn]] void fail(const std::string& message, size_t position) const {
+            const char* location = begin + std::min(position, size_t(end - begin));
+            const size_t line = std::count(begin, location, '\n') + 1;
+            const char* line_start = std::find(std::make_reverse_iterator(location),
+                                               std::make_reverse_iterator(begin), '\n').base();
+            throw parse_error(message, line, location - line_start + 1);
+        }
+
+        [[noreturn]] void fail(const std::string& message) const {
+            fail(message, position());
+        }
+
+        template<typename T>
+        T next(uint64_t bound = std::numeric_limits<T>::max()) {
+            skip_whitespace();
+            if (cursor == end) fail("unexpected end of input");
+            if (not is_digit(*cursor)) fail(std::string("expected a non-negative integer, found '") + *cursor + "'");
+            const char* const start = cursor;
+            uint64_t value = 0;
+            for (; cursor < end and is_digit(*cursor); ++cursor) value = value * 10 + uint8_t(*cursor - '0');
+            if (cursor - start > std::numeric_limits<uint64_t>::digits10
+                or value > std::min(bound, uint64_t(std::numeric_limits<T>::max())))
+                fail("integer " + std::string(start, cursor) + " is out of range", start - begin);
+            if (cursor < end and not is_space(*cursor)) fail(std::string("unexpected character '") + *cursor + "'");
+            return T(value);
+        }
+
+        [[nodiscard]] bool at_number() {
+            skip_whitespace();
+            return cursor < end and is_digit(*cursor);
+        }
+
+        /** Consumes the next token if it is <code>word</code>. */
+        bool accept(std::string_view word) {
+            skip_whitespace();
+            const auto token_end = std::find_if(cursor, end, is_space);
+            if (std::string_view(cursor, token_end - cursor) != word) return false;
+            cursor = token_end;
+            return true;
+        }
+
+        void skip(size_t tokens = 1) {
+            for (size_t i = 0; i < tokens; i++) {
+                skip_whitespace();
+                if (cursor == end) fail("unexpected end of input");
+                while (cursor < end and not is_space(*cursor)) ++cursor;
+            }
+        }
+    };
+}
+
+#endif //JOB_SHOP_PARSER
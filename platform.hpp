@@ -1,9 +1,15 @@
 #include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
 #include <cstdio>
 #include <filesystem>
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 
 #ifndef JOB_SHOP_PLATFORM
 #define JOB_SHOP_PLATFORM
@@ -14,6 +20,20 @@
 #define WINDOZE
 #endif
 
+#ifdef POSIX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
 #ifdef WINDOZE
 #define EXECUTABLE_PREFIX ""
 #define pipe_open _popen
@@ -42,6 +62,172 @@ namespace js {
         if (not std::filesystem::exists(directory)) std::filesystem::create_directories(directory);
     }
 
+    /**
+     * Read-only view of a whole file. On POSIX systems the file is memory-mapped, elsewhere it is read into memory.
+     */
+    class mapped_file {
+
+        const char* contents = nullptr;
+        size_t length = 0;
+#ifdef POSIX
+        void* mapping = MAP_FAILED;
+#else
+        std::string buffer;
+#endif
+
+    public:
+
+        explicit mapped_file(const std::string& path) {
+#ifdef POSIX
+            const int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor == -1) throw std::runtime_error("Could not open file " + path);
+            struct stat status{};
+            if (fstat(descriptor, &status) == 0) length = status.st_size;
+            if (length > 0) mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            ::close(descriptor);
+            if (length > 0 and mapping == MAP_FAILED) throw std::runtime_error("Could not map file " + path);
+            if (mapping != MAP_FAILED) {
+                madvise(mapping, length, MADV_SEQUENTIAL);
+                contents = static_cast<const char*>(mapping);
+            }
+#else
+            std::ifstream file(path, std::ios::binary);
+            if (not file.is_open()) throw std::runtime_error("Could not open file " + path);
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            contents = buffer.data();
+            length = buffer.size();
+#endif
+        }
+
+        mapped_file(const mapped_file&) = delete;
+
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        ~mapped_file() {
+#ifdef POSIX
+            if (mapping != MAP_FAILED) munmap(mapping, length);
+#endif
+        }
+
+        [[nodiscard]] std::string_view view() const {
+            return {contents, length};
+        }
+    };
+
+    /** Flag raised by SIGINT and SIGTERM once <code>handle_stop_signals</code> has been called. */
+    std::atomic<bool>& stop_signal() {
+        static std::atomic<bool> raised = false;
+        return raised;
+    }
+
+    void handle_stop_signals() {
+        static_assert(std::atomic<bool>::is_always_lock_free);
+        stop_signal();
+        const auto handler = [](int) { stop_signal().store(true, std::memory_order_relaxed); };
+        std::signal(SIGINT, handler);
+        std::signal(SIGTERM, handler);
+    }
+
+    /**
+     * Listening Unix domain socket serving one line-based connection at a time. Waiting polls in short steps, so a
+     * stop flag is noticed even though the signal handlers restart interrupted calls.
+     */
+    class unix_socket_server {
+#ifdef POSIX
+        int listener = -1, connection = -1;
+        std::string path, pending;
+
+        bool wait_readable(int descriptor, const std::atomic<bool>& stop) const {
+            pollfd request{descriptor, POLLIN, 0};
+            while (not stop.load(std::memory_order_relaxed))
+                if (poll(&request, 1, 100) > 0) return true;
+            return false;
+        }
+
+    public:
+
+        explicit unix_socket_server(const std::string& path) : path(path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+            path.copy(address.sun_path, path.size());
+            ::unlink(path.c_str());
+            listener = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listener == -1 or bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1
+                or listen(listener, 4) == -1)
+                throw std::runtime_error("Could not listen on socket " + path);
+        }
+
+        unix_socket_server(const unix_socket_server&) = delete;
+
+        unix_socket_server& operator=(const unix_socket_server&) = delete;
+
+        ~unix_socket_server() {
+            if (connection != -1) ::close(connection);
+            if (listener != -1) ::close(listener);
+            ::unlink(path.c_str());
+        }
+
+        /** Reads the next line of the current connection, accepting a new one when it closes. */
+        bool read_line(std::string& line, const std::atomic<bool>& stop) {
+            for (;;) {
+                if (const size_t end = pending.find('\n'); end != std::string::npos) {
+                    line.assign(pending, 0, end);
+                    pending.erase(0, end + 1);
+                    return true;
+                }
+                if (connection == -1) {
+                    if (not wait_readable(listener, stop)) return false;
+                    connection = accept(listener, nullptr, nullptr);
+                    continue;
+                }
+                if (not wait_readable(connection, stop)) return false;
+                std::array<char, 4096> buffer{};
+                const ssize_t received = ::read(connection, buffer.data(), buffer.size());
+                if (received > 0) pending.append(buffer.data(), size_t(received));
+                else {
+                    ::close(connection);
+                    connection = -1;
+                    pending.clear();
+                }
+            }
+        }
+
+        void write(std::string_view data) {
+            while (connection != -1 and not data.empty()) {
+                const ssize_t sent = ::send(connection, data.data(), data.size(), MSG_NOSIGNAL);
+                if (sent <= 0) return;
+                data.remove_prefix(size_t(sent));
+            }
+        }
+#else
+    public:
+
+        explicit unix_socket_server(const std::string& path) {
+            throw std::runtime_error("Unix sockets are not supported on this platform");
+        }
+
+        bool read_line(std::string& line, const std::atomic<bool>& stop) { return false; }
+
+        void write(std::string_view data) {}
+#endif
+    };
+
+    /** Peak resident set size of the process in bytes, or 0 where the platform does not report it. */
+    uint64_t peak_rss_bytes() {
+#ifdef POSIX
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+        return uint64_t(usage.ru_maxrss);
+#else
+        return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
     std::string execute(const std::string& command) {
         std::array<char, 128> buffer{};
         std::string result;
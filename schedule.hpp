@@ -1,16 +1,26 @@
 #ifndef JOB_SHOP_SCHEDULE
 #define JOB_SHOP_SCHEDULE
 
-#include <cmath>
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
 #include <numeric>
-#include <list>
-#include <sstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include "dataset.hpp"
+#include "heuristics.hpp"
+#include "instrumentation.hpp"
+#include "output.hpp"
 #include "platform.hpp"
 
 namespace js {
 
+    /** Polled by long-running constructions, which give up once it returns true. */
+    typedef std::function<bool()> stop_predicate;
+
     struct interval {
 
         time32_t start, end;
@@ -28,55 +38,229 @@ namespace js {
             return task_job_id != -1;
         }
 
-        [[nodiscard]] bool includes(time32_t time) const {
-            return start <= time and time <= end;
+        [[nodiscard]] time32_t length() const {
+            return end - start;
         }
 
         [[nodiscard]] bool includes(time32_t from, time32_t duration) const {
-            return std::max(start, from) + duration - 1 <= end;
+            const time32_t earliest = std::max(start, from);
+            return earliest <= end and duration <= end - earliest;
         }
     };
 
+    /**
+     * Machine timeline stored as a sorted, contiguous vector of free gaps (half-open intervals, the last one ending
+     * at infinity) and a vector of occupied intervals, sorted by start lazily on first read. A max-length segment
+     * tree over the gaps makes the earliest fitting gap lookup logarithmic. Blocked intervals, such as machine
+     * downtimes, are left out of the gaps and survive <code>clear()</code>.
+     */
     class timeline {
 
-        std::list<interval> intervals;
+        std::vector<interval> gaps{interval::empty()};
+        std::vector<interval> blocked;
+        mutable std::vector<interval> tasks;
+        mutable bool tasks_sorted = true;
+        std::vector<time32_t> longest;
+        size_t leaves = 0;
+        time32_t horizon = 0;
+
+        void rebuild() {
+            JS_COUNT(tree_rebuilds);
+            leaves = std::bit_ceil(gaps.size());
+            longest.assign(2 * leaves, 0);
+            for (size_t i = 0; i < gaps.size(); i++) longest[leaves + i] = gaps[i].length();
+            for (size_t node = leaves - 1; node > 0; node--)
+                longest[node] = std::max(longest[2 * node], longest[2 * node + 1]);
+        }
+
+        void update(size_t index) {
+            size_t node = leaves + index;
+            longest[node] = gaps[index].length();
+            for (node >>= 1; node > 0; node >>= 1) longest[node] = std::max(longest[2 * node], longest[2 * node + 1]);
+        }
+
+        void refresh(size_t from) {
+            if (gaps.size() > leaves) return rebuild();
+            const size_t to = std::min(gaps.size() + 1, leaves);
+            for (size_t i = from; i < to; i++) longest[leaves + i] = i < gaps.size() ? gaps[i].length() : 0;
+            for (size_t left = (leaves + from) >> 1, right = (leaves + to - 1) >> 1; left > 0; left >>= 1, right >>= 1)
+                for (size_t node = left; node <= right; node++)
+                    longest[node] = std::max(longest[2 * node], longest[2 * node + 1]);
+        }
+
+        [[nodiscard]] size_t first_fit(size_t from, time32_t duration) const {
+            size_t node = leaves + from;
+            if (longest[node] < duration) {
+                do {
+                    while (node & 1) if ((node >>= 1) == 0) return gaps.size();
+                    ++node;
+                } while (longest[node] < duration);
+                while (node < leaves) node = longest[2 * node] >= duration ? 2 * node : 2 * node + 1;
+            }
+            return node - leaves;
+        }
 
     public:
 
-        typedef std::list<interval>::iterator pointer;
+        struct slot {
+            size_t gap;
+            time32_t start;
+        };
+
+        timeline() {
+            rebuild();
+        }
+
+        void clear() {
+            tasks.clear();
+            tasks_sorted = true;
+            horizon = 0;
+            if (not blocked.empty()) {
+                gaps.clear();
+                time32_t free = 0;
+                for (const auto& range : blocked) {
+                    if (free < range.start) gaps.push_back(interval::empty(free, range.start));
+                    free = range.end;
+                }
+                gaps.push_back(interval::empty(free));
+                return rebuild();
+            }
+            gaps.assign(1, interval::empty());
+            std::fill(longest.begin(), longest.end(), 0);
+            update(0);
+        }
+
+        /** Makes <code>[start, end)</code> permanently unavailable; it must not overlap a placed task. */
+        void block(time32_t start, time32_t end) {
+            if (start >= end) return;
+            blocked.push_back(interval::empty(start, end));
+            std::sort(blocked.begin(), blocked.end(), [](const interval& a, const interval& b) {
+                return a.start < b.start;
+            });
+            size_t merged = 0;
+            for (size_t i = 1; i < blocked.size(); i++)
+                if (blocked[i].start <= blocked[merged].end)
+                    blocked[merged].end = std::max(blocked[merged].end, blocked[i].end);
+                else blocked[++merged] = blocked[i];
+            blocked.erase(blocked.begin() + std::ptrdiff_t(merged) + 1, blocked.end());
+
+            std::vector<interval> remaining;
+            remaining.reserve(gaps.size() + 1);
+            for (const auto& gap : gaps) {
+                if (gap.start < start) remaining.push_back(interval::empty(gap.start, std::min(gap.end, start)));
+                if (end < gap.end) remaining.push_back(interval::empty(std::max(gap.start, end), gap.end));
+            }
+            gaps = std::move(remaining);
+            rebuild();
+        }
 
-        [[nodiscard]] pointer interval_at(time32_t time) {
-            return std::find_if(intervals.begin(), intervals.end(),
-                                [=](const interval i) { return i.includes(time); });
+        [[nodiscard]] slot earliest_slot(time32_t from, time32_t duration) const {
+            JS_COUNT(slot_lookups);
+            const time32_t needed = std::max(duration, time32_t(1));
+            const size_t first = std::upper_bound(gaps.begin(), gaps.end(), from,
+                                                  [](time32_t time, const interval& gap) { return time < gap.end; })
+                                 - gaps.begin();
+            if (gaps[first].includes(from, needed)) return {first, std::max(gaps[first].start, from)};
+            const size_t gap = std::min(first_fit(first + 1, needed), gaps.size() - 1);
+            JS_COUNT(slot_descents);
+            JS_ADD(gaps_skipped, gap - first);
+            return {gap, gaps[gap].start};
+        }
+
+        [[nodiscard]] slot slot_at(time32_t start) const {
+            const auto gap = std::upper_bound(gaps.begin(), gaps.end(), start,
+                                              [](time32_t time, const interval& gap) { return time < gap.end; });
+            return {size_t(std::min(gap, gaps.end() - 1) - gaps.begin()), start};
+        }
+
+        void occupy(const slot& slot, time32_t duration, id32_t task_job_id) {
+            const time32_t end = slot.start + duration;
+            if (not tasks.empty() and slot.start < tasks.back().start) tasks_sorted = false;
+            tasks.emplace_back(slot.start, end, task_job_id);
+            horizon = std::max(horizon, end);
+            if (duration == 0) return;
+            interval& gap = gaps[slot.gap];
+            const bool empty_before = slot.start > gap.start, empty_after = end < gap.end;
+            if (empty_before and empty_after) {
+                const time32_t gap_end = gap.end;
+                gap.end = slot.start;
+                gaps.insert(gaps.begin() + std::ptrdiff_t(slot.gap) + 1, interval::empty(end, gap_end));
+                JS_COUNT(gap_splits);
+                refresh(slot.gap);
+            } else if (empty_before) {
+                gap.end = slot.start;
+                update(slot.gap);
+            } else if (empty_after) {
+                gap.start = end;
+                update(slot.gap);
+            } else {
+                gaps.erase(gaps.begin() + std::ptrdiff_t(slot.gap));
+                JS_COUNT(gap_erases);
+                refresh(slot.gap);
+            }
+        }
+
+        /**
+         * Forgets the history before <code>now</code>: the gaps ending by then are dropped, the first remaining gap
+         * is cut to start at <code>now</code> and the tasks that have ended are dropped. Slots found afterwards must
+         * not start before <code>now</code>.
+         */
+        void compact(time32_t now) {
+            const auto first = std::upper_bound(gaps.begin(), gaps.end(), now,
+                                                [](time32_t time, const interval& gap) { return time < gap.end; });
+            gaps.erase(gaps.begin(), std::min(first, gaps.end() - 1));
+            gaps.front().start = std::max(gaps.front().start, now);
+            std::erase_if(tasks, [now](const interval& task) { return task.end <= now; });
+            std::erase_if(blocked, [now](const interval& range) { return range.end <= now; });
+            rebuild();
         }
 
         [[nodiscard]] time32_t length() const {
-            const interval& last = intervals.back();
-            if (last.occupied()) return last.end + 1;
-            else return last.start;
+            return horizon;
         }
 
-        void add(interval&& interval) {
-            intervals.push_back(interval);
+        [[nodiscard]] const std::vector<interval>& occupied() const {
+            if (not tasks_sorted) {
+                JS_COUNT(task_sorts);
+                std::sort(tasks.begin(), tasks.end(),
+                          [](const interval& a, const interval& b) { return a.start < b.start; });
+                tasks_sorted = true;
+            }
+            return tasks;
         }
 
-        void insert_before(const pointer& it, interval&& interval) {
-            intervals.insert(it, interval);
+        [[nodiscard]] const std::vector<interval>& unavailable() const {
+            return blocked;
         }
 
-        void insert_after(const pointer& it, interval&& interval) {
-            intervals.insert(std::next(it), interval);
+        /** Start of the first gap: no task can be placed earlier. */
+        [[nodiscard]] time32_t first_free() const {
+            return gaps.front().start;
         }
 
-        [[nodiscard]] std::vector<id32_t> quantized(time32_t limit) const {
-            std::vector<id32_t> result(limit);
-            time32_t t = 0;
-            for (const auto& interval : intervals) {
-                for (time32_t i = interval.start; i <= interval.end and i < limit; i++) {
-                    if (interval.occupied()) result[t++] = interval.task_job_id;
-                    else result[t++] = -1;
-                }
+        /** Start of the <code>limit</code>-th most recent gap or task, 0 if there are not that many. */
+        [[nodiscard]] time32_t recent_history(size_t limit) const {
+            const auto& sorted = occupied();
+            if (gaps.size() + sorted.size() <= limit) return 0;
+            size_t gap = gaps.size(), task = sorted.size();
+            time32_t start = 0;
+            for (; limit > 0; limit--) {
+                const bool take_gap = task == 0 or (gap > 0 and gaps[gap - 1].start >= sorted[task - 1].start);
+                start = take_gap ? gaps[--gap].start : sorted[--task].start;
             }
+            return start;
+        }
+
+        /** Number of gaps, tasks and blocked intervals held, which compaction keeps bounded. */
+        [[nodiscard]] size_t stored_intervals() const {
+            return gaps.size() + tasks.size() + blocked.size();
+        }
+
+        [[nodiscard]] std::vector<id32_t> quantized(time32_t limit) const {
+            std::vector<id32_t> result(limit, -1);
+            for (const auto& task : tasks)
+                std::fill(result.begin() + std::min(task.start, limit), result.begin() + std::min(task.end, limit),
+                          task.task_job_id);
             return result;
         }
 
@@ -89,13 +273,14 @@ namespace js {
 
 #ifndef WINDOZE
 
-        static std::string colored(const char* text, id32_t color) {
-            return "\033[1;" + std::to_string(31 + color % 6) + "m" + text + "\033[0m";
+        static void write_colored(output_sink& sink, id32_t job_id, size_t width) {
+            sink.put("\033[1;").put_number(31 + job_id % 6).put('m');
+            sink.put_number(job_id, width).put("\033[0m");
         }
 
 #else
-        static std::string colored(const char* text, id32_t color) {
-            return text;
+        static void write_colored(output_sink& sink, id32_t job_id, size_t width) {
+            sink.put_number(job_id, width);
         }
 #endif
 
@@ -105,111 +290,216 @@ namespace js {
         size_t jobs_count = 0;
 
         explicit basic_schedule(size_t machine_count, size_t jobs_count)
-                : table(std::vector<timeline>(machine_count)), jobs_count(jobs_count) {
-            for (auto& timeline : table) timeline.add(interval::empty());
-        }
-
-        static void schedule_task(task& task, timeline& timeline, const timeline::pointer& interval, time32_t start) {
-
-            const time32_t interval_start = interval->start, interval_end = interval->end;
-            const bool empty_before = start > interval_start, empty_after = start + task.duration - 1 < interval_end;
-
-            interval->task_job_id = task.parent.id;
-            interval->start = start;
-            interval->end = start + task.duration - 1;
+                : table(std::vector<timeline>(machine_count)), jobs_count(jobs_count) {}
 
-            if (empty_before) timeline.insert_before(interval, interval::empty(interval_start, start - 1));
-            if (empty_after) timeline.insert_after(interval, interval::empty(start + task.duration, interval_end));
-
-            task.scheduled_time = start;
-            task.parent.last_scheduled_time = start + task.duration;
+        void clear() {
+            for (auto& timeline : table) timeline.clear();
         }
 
     public:
 
         basic_schedule() = default;
 
+        [[nodiscard]] const std::vector<timeline>& timelines() const {
+            return table;
+        }
+
         [[nodiscard]] time32_t longest_timeline() const {
             return std::max_element(table.begin(), table.end())->length();
         }
 
-        [[nodiscard]] std::string gantt_chart() {
-
-            std::ostringstream chart;
+        /**
+         * Writes the chart by walking the occupied intervals of every machine, one column per <code>scale</code>
+         * time units. A column shows the first task overlapping it, or <code>#</code> for blocked time.
+         */
+        void write_gantt_chart(output_sink& sink, time32_t scale = 1) const {
 
             const time32_t longest = longest_timeline();
-            const auto cell_width = uint8_t(std::max(std::log10(longest), std::log10(jobs_count)) + 1);
-            const auto left_col_width = uint8_t(std::log10(table.size()) + 1);
-            const std::string l_hd_format = "%0" + std::to_string(left_col_width) + "hd";
-            const std::string zu_format = "%0" + std::to_string(cell_width) + "zu";
-            const std::string hd_format = "%0" + std::to_string(cell_width) + "hd";
-            const char* fmt1 = l_hd_format.c_str(), * fmt2 = zu_format.c_str(), * fmt3 = hd_format.c_str();
-            const std::string empty = std::string(cell_width, '_') + '|';
-
-            chart << "   " + std::string(left_col_width, ' ');
-            char* id_string = new char[3];
-            for (time32_t i = 0; i < longest; i++) {
-                sprintf(id_string, fmt2, i);
-                chart << id_string << " ";
-            }
-            chart << std::endl;
-
-            for (id32_t machine_id = 0; machine_id < (id32_t) table.size(); machine_id++) {
-                sprintf(id_string, fmt1, machine_id);
-                chart << id_string << ": ";
-                chart << '|';
-                for (id32_t job_id : table[machine_id].quantized(longest)) {
-                    sprintf(id_string, fmt3, job_id);
-                    if (job_id == -1) chart << empty;
-                    else chart << colored(id_string, job_id) << '|';
+            const size_t cell_width = digits_count(std::max(size_t(longest), jobs_count));
+            const size_t left_col_width = digits_count(table.size());
+
+            sink.repeat(' ', 3 + left_col_width);
+            for (time32_t time = 0; time < longest; time += scale) sink.put_number(time, cell_width).put(' ');
+            sink.put('\n');
+
+            for (size_t machine_id = 0; machine_id < table.size(); machine_id++) {
+                sink.put_number(machine_id, left_col_width).put(": |");
+                const auto& tasks = table[machine_id].occupied();
+                const auto& blocked = table[machine_id].unavailable();
+                auto task = tasks.begin();
+                auto block = blocked.begin();
+                for (time32_t time = 0; time < longest; time += scale) {
+                    const time32_t column_end = time + std::min(scale, longest - time);
+                    while (task != tasks.end() and (task->end <= time or task->length() == 0)) ++task;
+                    while (block != blocked.end() and block->end <= time) ++block;
+                    if (task != tasks.end() and task->start < column_end)
+                        write_colored(sink, task->task_job_id, cell_width);
+                    else if (block != blocked.end() and block->start < column_end) sink.repeat('#', cell_width);
+                    else sink.repeat('_', cell_width);
+                    sink.put('|');
                 }
-                chart << std::endl;
+                sink.put('\n');
             }
+        }
 
-            delete[] id_string;
-            return chart.str();
-        };
+        [[nodiscard]] std::string gantt_chart(time32_t scale = 1) const {
+            std::string chart;
+            output_sink sink(chart);
+            write_gantt_chart(sink, scale);
+            sink.flush();
+            return chart;
+        }
     };
 
     class schedule : public basic_schedule {
 
-        dataset& data;
+        const instance& data;
+        solution_state state;
+        std::vector<id32_t> jobs_order, scratch;
+        std::vector<uint32_t> keys;
+        std::vector<timeline::slot> candidates;
+
+        void commit(id32_t job, size_t operation, id32_t machine, const timeline::slot& slot) {
+            const size_t index = data.index(job, operation);
+            const time32_t duration = data.durations[index];
+            table[machine].occupy(slot, duration, job);
+            state.scheduled_times[index] = slot.start;
+            state.job_ends[job] = slot.start + duration;
+            if (not state.assigned_machines.empty()) state.assigned_machines[index] = machine;
+        }
 
-        void add_task(task& task) {
-            timeline& timeline = table[task.machine_id];
-            const time32_t job_end = task.parent.last_scheduled_time;
-            auto time = timeline.interval_at(job_end);
-            while (time->occupied() or not time->includes(job_end, task.duration)) ++time;
-            schedule_task(task, timeline, time, std::max(time->start, job_end));
+        /**
+         * Places a task in the earliest slot of its machine or, in a flexible instance, of the eligible machine
+         * where it completes first. Every candidate has the same duration, so that is the earliest start; start and
+         * position are packed into one key whose minimum is taken without branching, ties going to the first
+         * machine listed, and the scan stops at a machine free as soon as the job is ready.
+         */
+        void add_task(id32_t job, size_t operation) {
+            const size_t index = data.index(job, operation);
+            const time32_t ready = state.job_ends[job], duration = data.durations[index];
+            if (not data.flexible()) {
+                JS_MACHINE(data.machines[index]);
+                return commit(job, operation, data.machines[index],
+                              table[data.machines[index]].earliest_slot(ready, duration));
+            }
+            const auto eligible = data.eligible_machines(index);
+            uint64_t best = std::numeric_limits<uint64_t>::max();
+            for (size_t i = 0; i < eligible.size(); i++) {
+                JS_MACHINE(eligible[i]);
+                candidates[i] = table[eligible[i]].earliest_slot(ready, duration);
+                best = std::min(best, uint64_t(candidates[i].start) << 32 | i);
+                if (candidates[i].start == ready) break;
+            }
+            const size_t chosen = best & std::numeric_limits<uint32_t>::max();
+            commit(job, operation, eligible[chosen], candidates[chosen]);
         }
 
     public:
 
-        explicit schedule(dataset& data) : basic_schedule(data.machines_count, data.jobs_count), data(data) {}
+        explicit schedule(const instance& data)
+                : basic_schedule(data.machines_count, data.jobs_count), data(data), state(data),
+                  jobs_order(data.jobs_count), scratch(data.jobs_count), keys(data.jobs_count),
+                  candidates(data.flexible() ? data.machines_count : 0) {
+            for (const auto& downtime : data.downtimes) table[downtime.machine].block(downtime.start, downtime.end);
+        }
+
+        void reset() {
+            clear();
+            state.reset(data);
+        }
+
+        [[nodiscard]] const instance& problem() const {
+            return data;
+        }
+
+        [[nodiscard]] const solution_state& solution() const {
+            return state;
+        }
+
+        void place_task(id32_t job, size_t operation, id32_t machine, time32_t start) {
+            JS_MACHINE(machine);
+            commit(job, operation, machine, table[machine].slot_at(start));
+        }
+
+        void place_task(id32_t job, size_t operation, time32_t start) {
+            place_task(job, operation, data.machine(job, operation), start);
+        }
+
+        void assign(const solution_state& solution) {
+            reset();
+            for (size_t job = 0; job < data.jobs_count; job++)
+                for (size_t i = 0; i < data.machines_count; i++) {
+                    const size_t index = data.index(job, i);
+                    place_task(id32_t(job), i, solution.machine(data, index), solution.scheduled_times[index]);
+                }
+        }
 
-        void schedule_jobs(const js::heuristic& heuristic) {
-            const size_t sequence_length = data.jobs[0].sequence.size();
-            for (size_t i = 0; i < sequence_length; i++) {
-                std::vector<js::job*> jobs_order(data.jobs_count);
-                std::iota(jobs_order.begin(), jobs_order.end(), &data.jobs[0]);
-                if (heuristic.first == sort) std::sort(jobs_order.begin(), jobs_order.end(),
-                          [=](const js::job* a, const js::job* b) { return heuristic.second(a, b, i); });
-                else if (heuristic.first == reverse)
+        /**
+         * Round-robin list scheduling: round <code>i</code> schedules the <code>i</code>-th operation of every job in
+         * the heuristic's order, after <code>perturb(order)</code> had a chance to shuffle it.
+         */
+        template<round_heuristic Heuristic, typename Perturbation = no_perturbation>
+        void schedule_jobs(Perturbation&& perturb = {}) {
+            for (size_t i = 0; i < data.machines_count; i++) {
+                std::iota(jobs_order.begin(), jobs_order.end(), 0);
+                if constexpr (Heuristic::mode == sort) {
+                    for (id32_t job = 0; job < id32_t(data.jobs_count); job++)
+                        keys[job] = Heuristic::key(data, job, i);
+                    sort_by_key(jobs_order, keys, scratch);
+                } else if constexpr (Heuristic::mode == reverse)
                     std::reverse(jobs_order.begin(), jobs_order.end());
-                for (job* job : jobs_order) add_task(job->sequence[i]);
+                perturb(jobs_order);
+                for (id32_t job : jobs_order) add_task(job, i);
             }
-            std::sort(data.jobs.begin(), data.jobs.end(), [](const job& a, const job& b) { return a.id < b.id; });
         }
 
-        [[nodiscard]] std::string summary() const {
-            std::ostringstream summary;
-            summary << longest_timeline() << '\n';
-            for (const auto& job : data.jobs) {
-                for (const auto& task : job.sequence) summary << task.scheduled_time << ' ';
-                summary << '\n';
+        [[nodiscard]] solution_record record() const {
+            return {data.jobs_count, data.machines_count, longest_timeline(), state.scheduled_times,
+                    state.assigned_machines};
+        }
+
+        void load(const solution_record& record) {
+            if (record.jobs_count != data.jobs_count or record.machines_count != data.machines_count)
+                throw std::runtime_error("Solution size does not match the instance");
+            if (record.machines.empty() == data.flexible())
+                throw std::runtime_error(data.flexible() ? "Solution does not list the machines of the tasks"
+                                                         : "Solution lists machines for a classic instance");
+            solution_state solution(data);
+            solution.scheduled_times = record.start_times;
+            if (std::any_of(record.machines.begin(), record.machines.end(),
+                            [this](id32_t machine) { return machine < 0 or size_t(machine) >= data.machines_count; }))
+                throw std::runtime_error("Solution refers to a machine outside the instance");
+            if (data.flexible()) solution.assigned_machines = record.machines;
+            assign(solution);
+        }
+
+        void write_binary(std::ostream& output) const {
+            record().write_binary(output);
+        }
+
+        void write_summary(output_sink& sink) const {
+            sink.put_number(longest_timeline()).put('\n');
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                for (size_t i = 0; i < data.machines_count; i++)
+                    sink.put_number(state.scheduled_times[data.index(job, i)]).put(' ');
+                sink.put('\n');
             }
-            return summary.str();
-        };
+            if (state.assigned_machines.empty()) return;
+            sink.put("machines\n");
+            for (size_t job = 0; job < data.jobs_count; job++) {
+                for (size_t i = 0; i < data.machines_count; i++)
+                    sink.put_number(state.assigned_machines[data.index(job, i)]).put(' ');
+                sink.put('\n');
+            }
+        }
+
+        [[nodiscard]] std::string summary() const {
+            std::string summary;
+            output_sink sink(summary);
+            write_summary(sink);
+            sink.flush();
+            return summary;
+        }
     };
 }
 
@@ -0,0 +1,320 @@
+#ifndef JOB_SHOP_SHIFTING_BOTTLENECK
+#define JOB_SHOP_SHIFTING_BOTTLENECK
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "bounds.hpp"
+#include "dataset.hpp"
+#include "schedule.hpp"
+#include "thread_pool.hpp"
+
+namespace js {
+
+    /**
+     * Carlier's branch and bound for one machine with release and delivery times: every task is a
+     * <code>{release, duration, tail}</code> triple and the objective is the largest completion plus tail. Each node
+     * runs Schrage's heuristic, then branches on the critical task by putting it before or after the critical set;
+     * Jackson's preemptive schedule bounds the children. The cost of a node grows with the number of tasks, so the
+     * search stops after <code>work_limit / tasks</code> nodes with the best sequence found so far.
+     */
+    class one_machine_solver {
+
+        std::vector<std::array<uint64_t, 3>> tasks;
+        std::vector<uint32_t> by_release, sequence, best_sequence;
+        std::vector<uint64_t> starts;
+        std::vector<std::pair<uint64_t, uint32_t>> released;
+        std::vector<std::pair<uint64_t, uint64_t>> preempted;
+        uint64_t upper = 0;
+        size_t nodes = 0, node_limit = 0;
+
+        [[nodiscard]] bool released_before(uint32_t a, uint32_t b) const {
+            return std::pair(tasks[a][0], a) < std::pair(tasks[b][0], b);
+        }
+
+        /** A branch changes one release at a time, so insertion sort keeps the release order in linear time. */
+        void sort_by_release() {
+            for (size_t i = 1; i < by_release.size(); i++)
+                for (size_t j = i; j > 0 and released_before(by_release[j], by_release[j - 1]); j--)
+                    std::swap(by_release[j], by_release[j - 1]);
+        }
+
+        uint64_t schrage() {
+            sort_by_release();
+            sequence.clear();
+            released.clear();
+            uint64_t time = 0, makespan = 0;
+            for (size_t i = 0; i < by_release.size() or not released.empty();) {
+                if (released.empty()) time = std::max(time, tasks[by_release[i]][0]);
+                for (; i < by_release.size() and tasks[by_release[i]][0] <= time; i++) {
+                    released.emplace_back(tasks[by_release[i]][2], by_release[i]);
+                    std::push_heap(released.begin(), released.end());
+                }
+                std::pop_heap(released.begin(), released.end());
+                const uint32_t task = released.back().second;
+                released.pop_back();
+                starts[task] = time;
+                time += tasks[task][1];
+                makespan = std::max(makespan, time + tasks[task][2]);
+                sequence.push_back(task);
+            }
+            return makespan;
+        }
+
+        uint64_t preemptive_bound() {
+            sort_by_release();
+            const auto task = [this](size_t i) -> const auto& { return tasks[by_release[i]]; };
+            return jackson_preemptive(by_release.size(), task, preempted);
+        }
+
+        void branch() {
+            if (++nodes > node_limit) return;
+            const uint64_t makespan = schrage();
+            if (makespan < upper) {
+                upper = makespan;
+                best_sequence = sequence;
+            }
+            const auto end_of = [this](uint32_t task) { return starts[task] + tasks[task][1]; };
+            size_t last = sequence.size() - 1;
+            while (end_of(sequence[last]) + tasks[sequence[last]][2] != makespan) last--;
+            size_t first = last;
+            while (first > 0 and end_of(sequence[first - 1]) == starts[sequence[first]]) first--;
+            size_t critical = last;
+            while (critical > first and tasks[sequence[critical - 1]][2] >= tasks[sequence[last]][2]) critical--;
+            if (critical == first) return;
+            const uint32_t task = sequence[--critical];
+
+            uint64_t release = std::numeric_limits<uint64_t>::max(), tail = release, length = 0;
+            for (size_t i = critical + 1; i <= last; i++) {
+                release = std::min(release, tasks[sequence[i]][0]);
+                length += tasks[sequence[i]][1];
+                tail = std::min(tail, tasks[sequence[i]][2]);
+            }
+            const uint64_t set_bound = release + length + tail;
+            const auto [task_release, task_duration, task_tail] = tasks[task];
+            const auto explore = [&] {
+                const uint64_t with_task = std::min(release, tasks[task][0]) + length + task_duration
+                                           + std::min(tail, tasks[task][2]);
+                if (std::max(set_bound, with_task) < upper and preemptive_bound() < upper) branch();
+            };
+            tasks[task][0] = std::max(task_release, release + length);
+            explore();
+            tasks[task][0] = task_release;
+            tasks[task][2] = std::max(task_tail, tail + length);
+            explore();
+            tasks[task][2] = task_tail;
+        }
+
+    public:
+
+        static constexpr size_t work_limit = size_t(1) << 10;
+
+        /** Solves the tasks, returns the best objective found and leaves its order in <code>order()</code>. */
+        uint64_t solve(const std::vector<std::array<uint64_t, 3>>& problem) {
+            tasks = problem;
+            by_release.resize(tasks.size());
+            for (uint32_t i = 0; i < by_release.size(); i++) by_release[i] = i;
+            std::sort(by_release.begin(), by_release.end(), [this](uint32_t a, uint32_t b) {
+                return released_before(a, b);
+            });
+            starts.resize(tasks.size());
+            best_sequence.clear();
+            upper = std::numeric_limits<uint64_t>::max();
+            nodes = 0;
+            node_limit = std::max<size_t>(work_limit / std::max<size_t>(tasks.size(), 1), 2);
+            if (not tasks.empty()) branch();
+            return tasks.empty() ? 0 : upper;
+        }
+
+        [[nodiscard]] const std::vector<uint32_t>& order() const {
+            return best_sequence;
+        }
+    };
+
+    /**
+     * Shifting bottleneck heuristic of Adams, Balas and Zawack. Machines are sequenced one at a time: the one-machine
+     * problems of the machines left, with releases and tails from the heads and tails of the disjunctive graph of the
+     * machines already sequenced, are solved in parallel and the machine with the largest optimum is sequenced next;
+     * then every sequenced machine is reoptimized against the others. The final start times are the heads.
+     */
+    class shifting_bottleneck {
+
+        typedef uint32_t node32_t;
+        static constexpr node32_t none = std::numeric_limits<node32_t>::max();
+        static constexpr size_t reoptimization_passes = 2, reoptimization_budget = size_t(1) << 18;
+
+        const instance& data;
+        const size_t nodes_count;
+        std::vector<std::vector<node32_t>> machine_tasks, sequences;
+        std::vector<node32_t> machine_prev, machine_next, order, in_degree, rank, kept;
+        std::vector<time32_t> heads, tails;
+        std::vector<std::vector<std::array<uint64_t, 3>>> problems;
+        std::vector<one_machine_solver> solvers;
+        std::vector<uint64_t> optima;
+        std::vector<uint8_t> sequenced;
+        std::vector<size_t> remaining;
+        solution_state solution;
+        time32_t makespan = 0;
+        size_t next_machine = 0;
+
+        [[nodiscard]] node32_t job_prev(node32_t node) const {
+            return node % data.machines_count == 0 ? none : node - 1;
+        }
+
+        [[nodiscard]] node32_t job_next(node32_t node) const {
+            return (node + 1) % data.machines_count == 0 ? none : node + 1;
+        }
+
+        [[nodiscard]] time32_t end_of(node32_t node) const {
+            return node == none ? 0 : heads[node] + data.durations[node];
+        }
+
+        [[nodiscard]] time32_t tail_from(node32_t node) const {
+            return node == none ? 0 : data.durations[node] + tails[node];
+        }
+
+        /** Heads, tails and makespan along <code>order</code>, which must be a topological order of the graph. */
+        void propagate() {
+            makespan = 0;
+            for (size_t i = 0; i < order.size(); i++) {
+                const node32_t node = order[i];
+                rank[node] = node32_t(i);
+                heads[node] = std::max(end_of(job_prev(node)), end_of(machine_prev[node]));
+                makespan = std::max(makespan, end_of(node));
+            }
+            for (auto node = order.rbegin(); node != order.rend(); ++node)
+                tails[*node] = std::max(tail_from(job_next(*node)), tail_from(machine_next[*node]));
+        }
+
+        /** Sorts the graph topologically and propagates; returns false if the fixed sequences form a cycle. */
+        bool evaluate() {
+            order.clear();
+            for (node32_t node = 0; node < nodes_count; node++) {
+                in_degree[node] = (job_prev(node) != none) + (machine_prev[node] != none);
+                if (in_degree[node] == 0) order.push_back(node);
+            }
+            for (size_t i = 0; i < order.size(); i++) {
+                const node32_t node = order[i];
+                for (const node32_t next : {job_next(node), machine_next[node]})
+                    if (next != none and --in_degree[next] == 0) order.push_back(next);
+            }
+            if (order.size() != nodes_count) return false;
+            propagate();
+            return true;
+        }
+
+        void solve_machine(size_t machine) {
+            auto& problem = problems[machine];
+            problem.clear();
+            for (const node32_t node : machine_tasks[machine])
+                problem.push_back({heads[node], data.durations[node], tails[node]});
+            optima[machine] = solvers[machine].solve(problem);
+            sequences[machine].clear();
+            for (const uint32_t task : solvers[machine].order())
+                sequences[machine].push_back(machine_tasks[machine][task]);
+        }
+
+        void link(const std::vector<node32_t>& sequence) {
+            for (size_t i = 0; i < sequence.size(); i++) {
+                machine_prev[sequence[i]] = i > 0 ? sequence[i - 1] : none;
+                machine_next[sequence[i]] = i + 1 < sequence.size() ? sequence[i + 1] : none;
+            }
+        }
+
+        void unlink(size_t machine) {
+            for (const node32_t node : machine_tasks[machine]) machine_prev[node] = machine_next[node] = none;
+        }
+
+        /**
+         * Fixes the sequence found for a machine whose tasks are unlinked. Ignoring the delayed precedences of the
+         * other machines, it may close a cycle; then the machine follows the topological order of the graph instead.
+         */
+        void fix(size_t machine) {
+            link(sequences[machine]);
+            if (evaluate()) return;
+            unlink(machine);
+            evaluate();
+            auto& sequence = sequences[machine];
+            std::sort(sequence.begin(), sequence.end(), [this](node32_t a, node32_t b) { return rank[a] < rank[b]; });
+            link(sequence);
+            evaluate();
+        }
+
+        /**
+         * Reoptimizes the sequenced machines one by one against the others, round-robin, at most
+         * <code>reoptimization_passes</code> times each and within a work budget that keeps large instances fast.
+         * Removing a machine's arcs keeps the topological order valid, so only a changed sequence needs a new sort; a
+         * sequence that closes a cycle or lengthens the makespan is rejected.
+         */
+        void reoptimize(size_t sequenced_count) {
+            const size_t budget = std::max<size_t>(reoptimization_budget / std::max<size_t>(nodes_count, 1), 1);
+            const size_t count = std::min(reoptimization_passes * sequenced_count, budget);
+            for (size_t done = 0; done < count; next_machine = (next_machine + 1) % data.machines_count) {
+                const size_t machine = next_machine;
+                if (not sequenced[machine]) continue;
+                done++;
+                const time32_t previous = makespan;
+                kept = sequences[machine];
+                unlink(machine);
+                propagate();
+                solve_machine(machine);
+                if (sequences[machine] == kept) {
+                    link(kept);
+                    propagate();
+                    continue;
+                }
+                link(sequences[machine]);
+                if (evaluate() and makespan <= previous) continue;
+                sequences[machine] = kept;
+                link(kept);
+                evaluate();
+            }
+        }
+
+    public:
+
+        explicit shifting_bottleneck(const instance& data)
+                : data(data), nodes_count(data.tasks_count()), machine_tasks(data.machines_count),
+                  sequences(data.machines_count), machine_prev(nodes_count, none), machine_next(nodes_count, none),
+                  in_degree(nodes_count), rank(nodes_count), heads(nodes_count), tails(nodes_count),
+                  problems(data.machines_count), solvers(data.machines_count), optima(data.machines_count),
+                  sequenced(data.machines_count), solution(data) {
+            for (node32_t node = 0; node < nodes_count; node++) machine_tasks[data.machines[node]].push_back(node);
+            order.reserve(nodes_count);
+        }
+
+        /**
+         * Builds a schedule into <code>schedule</code>, solving the one-machine problems of a step on the pool.
+         * Returns false, leaving the schedule untouched, if <code>stop</code> cut it short between two steps.
+         */
+        bool schedule_into(schedule& schedule, thread_pool& pool, const stop_predicate& stop = {}) {
+            std::fill(machine_prev.begin(), machine_prev.end(), none);
+            std::fill(machine_next.begin(), machine_next.end(), none);
+            std::fill(sequenced.begin(), sequenced.end(), false);
+            next_machine = 0;
+            evaluate();
+            for (size_t step = 0; step < data.machines_count; step++) {
+                if (stop and stop()) return false;
+                remaining.clear();
+                for (size_t machine = 0; machine < data.machines_count; machine++)
+                    if (not sequenced[machine]) remaining.push_back(machine);
+                pool.parallel_for(remaining.size(), [this](size_t i) { solve_machine(remaining[i]); });
+                size_t bottleneck = remaining.front();
+                for (const size_t machine : remaining) if (optima[machine] > optima[bottleneck]) bottleneck = machine;
+                fix(bottleneck);
+                sequenced[bottleneck] = true;
+                reoptimize(step + 1);
+            }
+            std::copy(heads.begin(), heads.end(), solution.scheduled_times.begin());
+            for (size_t job = 0; job < data.jobs_count; job++)
+                solution.job_ends[job] = end_of(node32_t(data.index(job, data.machines_count - 1)));
+            schedule.assign(solution);
+            return true;
+        }
+    };
+}
+
+#endif //JOB_SHOP_SHIFTING_BOTTLENECK
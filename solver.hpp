@@ -0,0 +1,265 @@
+#ifndef JOB_SHOP_SOLVER
+#define JOB_SHOP_SOLVER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "bounds.hpp"
+#include "branch_and_bound.hpp"
+#include "cache.hpp"
+#include "dataset.hpp"
+#include "engines.hpp"
+#include "grasp.hpp"
+#include "instrumentation.hpp"
+#include "schedule.hpp"
+#include "tabu_search.hpp"
+#include "thread_pool.hpp"
+#include "timer.hpp"
+#include "validator.hpp"
+
+namespace js {
+
+    struct solver_options {
+        std::vector<std::string> engine_names;
+        uint64_t time_limit = 0, deadline = 0, grasp_starts = 0, seed = 0, node_limit = uint64_t(1) << 20;
+        uint16_t limit = 0;
+        bool exact = false;
+        /** Name reported with progress lines; batches set it to the file name of each instance. */
+        std::string instance;
+        std::function<void(const std::string&, uint64_t, time32_t)> on_improvement;
+        const std::atomic<bool>* stop = nullptr;
+        solution_cache* cache = nullptr;
+    };
+
+    /**
+     * Portfolio solver for one instance: runs every selected engine, keeps the shortest schedule and optionally
+     * improves it with tabu search for <code>time_limit</code> milliseconds. Engines that have not started yet are
+     * skipped and the search is not run once a schedule reaches the lower bound, as it is then provably optimal.
+     * <code>grasp_starts</code> randomized greedy schedules may then be built on the pool and the best one kept.
+     * With a <code>deadline</code> (milliseconds from the start of <code>solve</code>), the search is cut to fit it
+     * and the remaining time goes to randomized restarts of the list heuristics with perturbed job orders. A stop
+     * request or the deadline also ends the engines early: engines not started yet are skipped and the long ones give
+     * up between operations or machines. The best schedule so far is returned either way, or, if no engine finished,
+     * a list schedule built on the spot. Instances with
+     * eligible machines or downtimes only get the general engines and skip the tabu search, whose neighbourhood
+     * assumes fixed machines and no downtimes.
+     *
+     * In <code>exact</code> mode the best schedule so far, that of the engines unless GRASP or the search improved it,
+     * seeds a branch and bound cut to <code>node_limit</code> nodes and the deadline; a complete search proves its
+     * result optimal and skips the restarts.
+     *
+     * With a <code>cache</code>, a valid cached schedule for the same instance, engines and exact mode is returned as
+     * is, or, when an improvement phase is enabled, replaces the engines as the starting point whatever the budget
+     * of the run that stored it. Improved or newly solved schedules are stored back.
+     */
+    class solver {
+
+        const instance& data;
+        const solver_options& options;
+        std::vector<std::unique_ptr<engine>> engines;
+        std::vector<const char*> engine_names;
+        std::vector<schedule> schedules;
+        std::vector<uint8_t> finished;
+        std::atomic<bool> optimal = false;
+        lower_bounds bounds;
+        schedule improved, candidate;
+        std::mt19937 random;
+        grasp multi_start;
+        tabu_search search;
+        tabu_search::statistics statistics;
+        branch_and_bound exact;
+        branch_and_bound::statistics exact_statistics;
+        bool proven = false;
+        solution_record cached;
+
+        typedef random_swaps<std::mt19937> perturbation;
+
+        [[nodiscard]] bool stop_requested() const {
+            return options.stop != nullptr and options.stop->load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Cache key: the instance and the options that shape the schedule. The improvement budgets (time limit,
+         * deadline, GRASP starts and seed) are left out, so that any run finds the best schedule stored by the others
+         * and improves on it.
+         */
+        [[nodiscard]] uint64_t cache_key() const {
+            fingerprint key;
+            key.add(data).add(options.engine_names.size());
+            for (const auto& name : options.engine_names) key.add(name);
+            return key.add(options.exact).add(options.node_limit).value();
+        }
+
+        /** Runs the phases, starting from the schedule in <code>improved</code> instead of the engines if warm. */
+        const schedule& run(thread_pool& pool, bool warm_start) {
+            timer<precision::us> clock;
+            clock.start();
+            const time32_t bound = bounds.value();
+            const uint64_t deadline_us = options.deadline > 0 ? options.deadline * 1000 : UINT64_MAX;
+            const stop_predicate out_of_time = [&] {
+                return stop_requested() or uint64_t(clock.get_elapsed_time()) >= deadline_us;
+            };
+            optimal = false;
+            std::fill(finished.begin(), finished.end(), false);
+            for (size_t e = 0; e < engines.size() and not warm_start; e++)
+                pool.submit([this, e, &pool, &out_of_time] {
+                    if (optimal.load(std::memory_order_relaxed) or out_of_time()) return;
+                    JS_HEURISTIC(engine_names[e]);
+                    JS_SCOPE(engine_names[e]);
+                    if (not engines[e]->run(schedules[e], pool, out_of_time)) return;
+                    finished[e] = true;
+                    if (schedules[e].longest_timeline() <= bounds.value())
+                        optimal.store(true, std::memory_order_relaxed);
+                });
+            pool.wait();
+
+            const schedule* solution = warm_start ? &improved : nullptr;
+            for (size_t e = 0; e < engines.size(); e++)
+                if (finished[e] and (solution == nullptr
+                                     or schedules[e].longest_timeline() < solution->longest_timeline()))
+                    solution = &schedules[e];
+            if (solution == nullptr) {
+                JS_SCOPE("fallback");
+                improved.reset();
+                improved.schedule_jobs<heuristics::pass>();
+                solution = &improved;
+            }
+            const auto report = [&](time32_t makespan) {
+                if (options.on_improvement)
+                    options.on_improvement(options.instance, uint64_t(clock.get_elapsed_time()), makespan);
+            };
+            report(solution->longest_timeline());
+
+            if (options.grasp_starts > 0 and solution->longest_timeline() > bound and not stop_requested()) {
+                const uint64_t elapsed_us = std::min(deadline_us, uint64_t(clock.get_elapsed_time()));
+                JS_SCOPE("grasp");
+                const time32_t makespan = multi_start.run(pool, options.grasp_starts, options.seed, bound,
+                                                          deadline_us - elapsed_us, options.stop);
+                if (makespan < solution->longest_timeline()) {
+                    improved.assign(multi_start.best_solution());
+                    solution = &improved;
+                    report(solution->longest_timeline());
+                }
+            }
+
+            if (options.time_limit > 0 and data.classic() and solution->longest_timeline() > bound
+                and not stop_requested()) {
+                const uint64_t elapsed_us = std::min(deadline_us, uint64_t(clock.get_elapsed_time()));
+                JS_SCOPE("tabu_search");
+                search.start_from(solution->solution());
+                statistics = search.run(std::min(options.time_limit * 1000, deadline_us - elapsed_us), bound, report,
+                                        options.stop);
+                if (search.best_makespan_found() < solution->longest_timeline()) {
+                    improved.assign(search.best_solution());
+                    solution = &improved;
+                }
+            }
+
+            proven = solution->longest_timeline() <= bound;
+            if (options.exact and data.classic() and not proven and not stop_requested()) {
+                const uint64_t elapsed_us = std::min(deadline_us, uint64_t(clock.get_elapsed_time()));
+                JS_SCOPE("branch_and_bound");
+                exact_statistics = exact.run(pool, solution->solution(), solution->longest_timeline(), bound,
+                                             options.node_limit, deadline_us - elapsed_us, options.stop);
+                if (exact.best_makespan_found() < solution->longest_timeline()) {
+                    improved.assign(exact.best_solution());
+                    solution = &improved;
+                    report(solution->longest_timeline());
+                }
+                proven = exact_statistics.complete or solution->longest_timeline() <= bound;
+                if (proven) return *solution;
+            }
+
+            if (options.deadline > 0) {
+                JS_HEURISTIC("restarts");
+                JS_SCOPE("restarts");
+                const size_t max_swaps = data.jobs_count;
+                for (size_t r = 0; solution->longest_timeline() > bound and not stop_requested()
+                                   and uint64_t(clock.get_elapsed_time()) < deadline_us; r++) {
+                    const perturbation perturb{random, std::uniform_int_distribution<size_t>(1, max_swaps)(random)};
+                    list_restarts<perturbation>[r % list_restarts<perturbation>.size()](candidate, perturb);
+                    if (candidate.longest_timeline() < solution->longest_timeline()) {
+                        improved.assign(candidate.solution());
+                        solution = &improved;
+                        report(solution->longest_timeline());
+                    }
+                }
+                proven = solution->longest_timeline() <= bound;
+            }
+            return *solution;
+        }
+
+    public:
+
+        solver(const instance& data, const solver_options& options)
+                : data(data), options(options), bounds(compute_lower_bounds(data)), improved(data), candidate(data),
+                  random(options.seed), multi_start(data), search(data, options.seed), exact(data) {
+            if (options.engine_names.empty())
+                for (const auto& entry : engine_registry()) {
+                    if (not entry.general and not data.classic()) continue;
+                    engines.push_back(entry.create(data));
+                    engine_names.push_back(entry.name);
+                }
+            else for (const auto& name : options.engine_names) {
+                engines.push_back(create_engine(name, data));
+                engine_names.push_back(name.c_str());
+            }
+            schedules.reserve(engines.size());
+            for (size_t e = 0; e < engines.size(); e++) schedules.emplace_back(data);
+            finished.resize(engines.size());
+        }
+
+        [[nodiscard]] const lower_bounds& lower_bound() const {
+            return bounds;
+        }
+
+        [[nodiscard]] size_t engines_count() const {
+            return engines.size();
+        }
+
+        [[nodiscard]] const tabu_search::statistics& search_statistics() const {
+            return statistics;
+        }
+
+        [[nodiscard]] const branch_and_bound::statistics& exact_search_statistics() const {
+            return exact_statistics;
+        }
+
+        /** Whether the last schedule returned reaches the lower bound or survived a complete branch and bound. */
+        [[nodiscard]] bool proven_optimal() const {
+            return proven;
+        }
+
+        const schedule& solve(thread_pool& pool) {
+            JS_SCOPE("solve");
+            statistics = {};
+            exact_statistics = {};
+            if (options.cache == nullptr) return run(pool, false);
+
+            const uint64_t key = cache_key();
+            bool hit = false;
+            if (options.cache->lookup(key, cached)) {
+                try {
+                    improved.load(cached);
+                    hit = validate(improved).valid();
+                } catch (const std::exception&) {}
+            }
+            const bool improving = options.time_limit > 0 or options.deadline > 0 or options.grasp_starts > 0
+                                   or options.exact;
+            if (hit and not improving) {
+                proven = improved.longest_timeline() <= bounds.value();
+                return improved;
+            }
+            const schedule& solution = run(pool, hit);
+            if (not hit or solution.longest_timeline() < cached.makespan) options.cache->store(key, solution.record());
+            return solution;
+        }
+    };
+}
+
+#endif //JOB_SHOP_SOLVER
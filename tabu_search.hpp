@@ -0,0 +1,247 @@
+#ifndef JOB_SHOP_TABU_SEARCH
+#define JOB_SHOP_TABU_SEARCH
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "dataset.hpp"
+#include "timer.hpp"
+
+namespace js {
+
+    /**
+     * Tabu search over the disjunctive graph using the N5 neighbourhood of Nowicki and Smutnicki: swaps of the
+     * first or last two operations of the blocks on a critical path. Moves are evaluated from the heads and tails
+     * of the current solution; only the accepted move triggers a full recomputation of the heads and tails.
+     */
+    class tabu_search {
+
+        typedef uint32_t node32_t;
+        static constexpr node32_t none = std::numeric_limits<node32_t>::max();
+        static constexpr size_t tabu_tenure = 10;
+
+        struct move {
+            node32_t first, second;
+            time32_t estimate;
+        };
+
+        const instance& data;
+        const size_t nodes_count;
+        std::vector<node32_t> machine_prev, machine_next, best_machine_prev, best_machine_next;
+        std::vector<node32_t> order, in_degree, path;
+        std::vector<time32_t> heads, tails;
+        std::vector<move> moves;
+        std::array<std::pair<node32_t, node32_t>, tabu_tenure> tabu_list{};
+        size_t tabu_position = 0;
+        solution_state best;
+        time32_t makespan = 0, best_makespan = 0;
+        std::mt19937 random;
+
+        [[nodiscard]] node32_t job_prev(node32_t node) const {
+            return node % data.machines_count == 0 ? none : node - 1;
+        }
+
+        [[nodiscard]] node32_t job_next(node32_t node) const {
+            return (node + 1) % data.machines_count == 0 ? none : node + 1;
+        }
+
+        [[nodiscard]] time32_t end_of(node32_t node) const {
+            return node == none ? 0 : heads[node] + data.durations[node];
+        }
+
+        [[nodiscard]] time32_t tail_from(node32_t node) const {
+            return node == none ? 0 : data.durations[node] + tails[node];
+        }
+
+        void evaluate() {
+            order.clear();
+            for (node32_t node = 0; node < nodes_count; node++) {
+                in_degree[node] = (job_prev(node) != none) + (machine_prev[node] != none);
+                if (in_degree[node] == 0) order.push_back(node);
+            }
+            for (size_t i = 0; i < order.size(); i++) {
+                const node32_t node = order[i];
+                for (const node32_t next : {job_next(node), machine_next[node]})
+                    if (next != none and --in_degree[next] == 0) order.push_back(next);
+            }
+            if (order.size() != nodes_count) throw std::logic_error("Tabu search produced a cyclic solution");
+            makespan = 0;
+            for (const node32_t node : order) {
+                heads[node] = std::max(end_of(job_prev(node)), end_of(machine_prev[node]));
+                makespan = std::max(makespan, end_of(node));
+            }
+            for (auto node = order.rbegin(); node != order.rend(); ++node)
+                tails[*node] = std::max(tail_from(job_next(*node)), tail_from(machine_next[*node]));
+        }
+
+        void critical_path() {
+            path.clear();
+            node32_t node = none;
+            for (node32_t candidate = 0; candidate < nodes_count and node == none; candidate++)
+                if (end_of(candidate) == makespan and tails[candidate] == 0) node = candidate;
+            while (node != none) {
+                path.push_back(node);
+                const node32_t machine = machine_prev[node], job = job_prev(node);
+                if (machine != none and end_of(machine) == heads[node]) node = machine;
+                else if (job != none and end_of(job) == heads[node]) node = job;
+                else node = none;
+            }
+            std::reverse(path.begin(), path.end());
+        }
+
+        [[nodiscard]] time32_t estimate(node32_t u, node32_t v) const {
+            const time32_t head_v = std::max(end_of(job_prev(v)), end_of(machine_prev[u]));
+            const time32_t head_u = std::max(end_of(job_prev(u)), head_v + data.durations[v]);
+            const time32_t tail_u = std::max(tail_from(job_next(u)), tail_from(machine_next[v]));
+            const time32_t tail_v = std::max(tail_from(job_next(v)), data.durations[u] + tail_u);
+            return std::max(head_v + data.durations[v] + tail_v, head_u + data.durations[u] + tail_u);
+        }
+
+        void neighbourhood() {
+            moves.clear();
+            critical_path();
+            size_t block_start = 0;
+            for (size_t i = 1; i <= path.size(); i++) {
+                if (i < path.size() and machine_next[path[i - 1]] == path[i]) continue;
+                const size_t block_end = i - 1;
+                if (block_end > block_start) {
+                    if (block_start > 0) moves.push_back({path[block_start], path[block_start + 1], 0});
+                    if (i < path.size() and (block_start == 0 or block_end - block_start > 1))
+                        moves.push_back({path[block_end - 1], path[block_end], 0});
+                }
+                block_start = i;
+            }
+            for (auto& move : moves) move.estimate = estimate(move.first, move.second);
+        }
+
+        [[nodiscard]] bool is_tabu(const move& move) const {
+            return std::find(tabu_list.begin(), tabu_list.end(), std::make_pair(move.second, move.first))
+                   != tabu_list.end();
+        }
+
+        void swap(node32_t u, node32_t v) {
+            const node32_t before = machine_prev[u], after = machine_next[v];
+            machine_prev[v] = before;
+            if (before != none) machine_next[before] = v;
+            machine_next[v] = u;
+            machine_prev[u] = v;
+            machine_next[u] = after;
+            if (after != none) machine_prev[after] = u;
+            tabu_list[tabu_position++ % tabu_tenure] = {u, v};
+        }
+
+        void store_best() {
+            best_makespan = makespan;
+            best_machine_prev = machine_prev;
+            best_machine_next = machine_next;
+            std::copy(heads.begin(), heads.end(), best.scheduled_times.begin());
+            for (size_t job = 0; job < data.jobs_count; job++)
+                best.job_ends[job] = end_of(node32_t(data.index(job, data.machines_count - 1)));
+        }
+
+        void restart_from_best() {
+            machine_prev = best_machine_prev;
+            machine_next = best_machine_next;
+            tabu_list.fill({none, none});
+            evaluate();
+            std::uniform_int_distribution<size_t> perturbations(1, 4);
+            for (size_t i = perturbations(random); i > 0; i--) {
+                neighbourhood();
+                if (moves.empty()) break;
+                const move& move = moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(random)];
+                swap(move.first, move.second);
+                evaluate();
+            }
+        }
+
+    public:
+
+        struct statistics {
+            uint64_t iterations = 0, evaluated_moves = 0, elapsed_us = 0;
+        };
+
+        explicit tabu_search(const instance& data, uint32_t seed = 0)
+                : data(data), nodes_count(data.tasks_count()), machine_prev(nodes_count, none),
+                  machine_next(nodes_count, none), in_degree(nodes_count), heads(nodes_count), tails(nodes_count),
+                  best(data), random(seed) {
+            order.reserve(nodes_count);
+            path.reserve(nodes_count);
+        }
+
+        void start_from(const solution_state& solution) {
+            std::vector<std::vector<node32_t>> sequences(data.machines_count);
+            for (node32_t node = 0; node < nodes_count; node++) sequences[data.machines[node]].push_back(node);
+            const auto& start = solution.scheduled_times;
+            for (auto& sequence : sequences) {
+                std::sort(sequence.begin(), sequence.end(), [&](node32_t a, node32_t b) {
+                    const time32_t end_a = start[a] + data.durations[a], end_b = start[b] + data.durations[b];
+                    return std::tie(start[a], end_a, a) < std::tie(start[b], end_b, b);
+                });
+                for (size_t i = 0; i < sequence.size(); i++) {
+                    machine_prev[sequence[i]] = i > 0 ? sequence[i - 1] : none;
+                    machine_next[sequence[i]] = i + 1 < sequence.size() ? sequence[i + 1] : none;
+                }
+            }
+            tabu_list.fill({none, none});
+            evaluate();
+            store_best();
+        }
+
+        /**
+         * Searches until the time limit, the target makespan or a stop request. <code>on_improvement</code> is called
+         * with every new best makespan.
+         */
+        statistics run(uint64_t time_limit_us, time32_t target = 0,
+                       const std::function<void(time32_t)>& on_improvement = {},
+                       const std::atomic<bool>* stop = nullptr) {
+            statistics stats;
+            timer<precision::us> clock;
+            clock.start();
+            const uint64_t stagnation_limit = 1000 + 10 * nodes_count;
+            uint64_t since_improvement = 0;
+            while (best_makespan > target) {
+                if (stats.iterations % 64 == 0 and (clock.get_elapsed_time() >= time_limit_us
+                                                    or (stop != nullptr and stop->load(std::memory_order_relaxed))))
+                    break;
+                stats.iterations++;
+                neighbourhood();
+                if (moves.empty()) break;
+                stats.evaluated_moves += moves.size();
+                const move* chosen = nullptr;
+                for (const auto& move : moves)
+                    if ((move.estimate < best_makespan or not is_tabu(move))
+                        and (chosen == nullptr or move.estimate < chosen->estimate))
+                        chosen = &move;
+                if (chosen == nullptr) chosen = &moves.front();
+                swap(chosen->first, chosen->second);
+                evaluate();
+                if (makespan < best_makespan) {
+                    store_best();
+                    if (on_improvement) on_improvement(best_makespan);
+                    since_improvement = 0;
+                } else if (++since_improvement >= stagnation_limit) {
+                    restart_from_best();
+                    since_improvement = 0;
+                }
+            }
+            clock.stop();
+            stats.elapsed_us = clock.get_measured_time();
+            return stats;
+        }
+
+        [[nodiscard]] time32_t best_makespan_found() const {
+            return best_makespan;
+        }
+
+        [[nodiscard]] const solution_state& best_solution() const {
+            return best;
+        }
+    };
+}
+
+#endif //JOB_SHOP_TABU_SEARCH
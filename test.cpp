@@ -1,32 +1,423 @@
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <sstream>
+#include <tuple>
+#include <utility>
+#include "batch.hpp"
+#include "bounds.hpp"
+#include "branch_and_bound.hpp"
+#include "cache.hpp"
+#include "engines.hpp"
+#include "incremental.hpp"
+#include "online.hpp"
 #include "platform.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+#include "validator.hpp"
 
-void run_test(const std::string& solver_executable, const std::string& checker_executable,
-              const std::string& data_directory, const std::string& output_directory) {
-    for (const auto& entry : std::filesystem::directory_iterator(data_directory)) {
-        const std::string input = entry.path().string();
-        const std::string output = output_directory + js::path_sep + entry.path().filename().string();
-        js::execute((std::ostringstream{} << EXECUTABLE_PREFIX << solver_executable
-                                          << " -d " << input << " -o " << output).str());
-        if (not checker_executable.empty()) {
-            const std::string feedback = js::execute((std::ostringstream{} << EXECUTABLE_PREFIX << checker_executable
-                                                                           << " " << input << " " << output).str());
-            if (feedback.find("OK") != std::string::npos) std::cout << "[ OK ] " << input << " -> " << output << std::endl;
-            else std::cerr << "[FAIL] " << input << " -> " << output << "\n" << feedback << std::endl;
+int run_test(const std::string& data_directory, const std::string& output_directory, size_t threads_count) {
+    js::thread_pool pool(threads_count > 1 ? threads_count : 0);
+    const auto results = js::solve_batch(js::list_instances(data_directory), {}, output_directory, pool, std::cout,
+                                         true);
+    int failures = 0;
+    for (const auto& result : results) {
+        const std::string& input = result.input;
+        const std::string output = output_directory + js::path_sep + js::extract_file_name(input);
+        if (result.error.empty() and result.verification == "OK")
+            std::cout << "[ OK ] " << input << " -> " << output << std::endl;
+        else {
+            std::cerr << "[FAIL] " << input << " -> " << output << "\n"
+                      << (result.error.empty() ? result.verification : result.error) << std::endl;
+            failures++;
         }
     }
+    return failures == 0 ? 0 : 1;
+}
+
+/** Prints the outcome of a named check and returns 1 when it failed, so that checks can be summed. */
+int report(bool passed, const std::string& name, const std::string& details = {}) {
+    if (passed) std::cout << "[ OK ] " << name << std::endl;
+    else std::cerr << "[FAIL] " << name << "\n" << details << std::endl;
+    return passed ? 0 : 1;
+}
+
+/**
+ * Streams jobs without release times into online schedules. Compacting only behind "now" must place every task as
+ * a schedule that never compacts does, and the default history limit must keep memory flat for a makespan close to
+ * the exact one.
+ */
+int run_online_test(size_t machines_count, size_t jobs_count) {
+    js::online_schedule exact(machines_count, 0), uncompacted(machines_count, jobs_count * machines_count),
+            bounded(machines_count);
+    std::mt19937 random(0);
+    std::vector<size_t> machines(machines_count);
+    std::iota(machines.begin(), machines.end(), 0);
+    std::vector<std::pair<js::id32_t, js::time32_t>> operations;
+    const size_t limit = machines_count * 3 * js::online_schedule::default_history_limit;
+    size_t peak = 0, mismatches = 0;
+    js::time32_t exact_makespan = 0, bounded_makespan = 0;
+    const auto completion = [&](const std::vector<js::time32_t>& starts) {
+        js::time32_t end = 0;
+        for (size_t i = 0; i < starts.size(); i++) end = std::max(end, starts[i] + operations[i].second);
+        return end;
+    };
+    for (size_t job = 0; job < jobs_count; job++) {
+        std::shuffle(machines.begin(), machines.end(), random);
+        operations.clear();
+        for (const size_t machine : machines) operations.emplace_back(machine, 1 + random() % 99);
+        const std::vector<js::time32_t> starts = exact.add_job(operations, 0);
+        mismatches += starts != uncompacted.add_job(operations, 0);
+        exact_makespan = std::max(exact_makespan, completion(starts));
+        bounded_makespan = std::max(bounded_makespan, completion(bounded.add_job(operations, 0)));
+        peak = std::max(peak, bounded.stored_intervals());
+    }
+    const std::string name = "online: " + std::to_string(jobs_count) + " jobs without releases on "
+                             + std::to_string(machines_count) + " machines";
+    int failures = report(mismatches == 0, name + ", compaction behind now keeps every start",
+                          std::to_string(mismatches) + " jobs placed differently");
+    failures += report(peak <= limit and bounded_makespan <= exact_makespan + exact_makespan / 20,
+                       name + ", history limit stores at most " + std::to_string(peak) + " intervals, makespan "
+                           + std::to_string(bounded_makespan) + " against " + std::to_string(exact_makespan),
+                       "limit " + std::to_string(limit) + " intervals and 5% of the makespan");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Applies random what-if edits to an incremental schedule. After every edit, its starts must be those a full
+ * propagation from scratch gives over the same machine orders: every task as early as its job predecessor, its machine
+ * predecessor and the blocked intervals of its machine allow.
+ */
+int run_what_if_test(const std::string& data_directory, size_t edits_count) {
+    js::instance data;
+    data.load_from_file(data_directory + js::path_sep + "ft10.txt");
+    js::schedule initial(data);
+    initial.schedule_jobs<js::heuristics::pass>();
+    js::incremental_schedule what_if(initial);
+    const size_t machines_count = data.machines_count;
+    std::vector<std::vector<std::pair<js::time32_t, js::time32_t>>> blocked(machines_count);
+    const auto available_start = [&](size_t machine, js::time32_t from, js::time32_t duration) {
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (const auto& [start, end] : blocked[machine])
+                if (from < end and start < from + duration) from = end, moved = true;
+        }
+        return from;
+    };
+    std::mt19937 random(0);
+    std::vector<size_t> jobs, machines(machines_count);
+    std::iota(machines.begin(), machines.end(), 0);
+    std::vector<std::pair<js::id32_t, js::time32_t>> operations;
+    std::vector<std::tuple<js::time32_t, size_t, size_t>> tasks;
+    std::vector<js::time32_t> expected;
+    std::vector<size_t> machine_prev, last;
+    std::string failure;
+    for (size_t edit = 0; edit < edits_count and failure.empty(); edit++) {
+        jobs.clear();
+        for (size_t job = 0; job < what_if.jobs(); job++)
+            if (what_if.contains(job)) jobs.push_back(job);
+        const size_t job = jobs[random() % jobs.size()], operation = random() % machines_count;
+        std::string name;
+        switch (random() % 4) {
+            case 0:
+                std::shuffle(machines.begin(), machines.end(), random);
+                operations.clear();
+                for (const size_t machine : machines) operations.emplace_back(js::id32_t(machine), 1 + random() % 99);
+                what_if.add_job(operations);
+                name = "add_job";
+                break;
+            case 1:
+                if (jobs.size() > 1) what_if.remove_job(job);
+                name = "remove_job " + std::to_string(job);
+                break;
+            case 2: {
+                const js::id32_t machine = what_if.machine(job, operation);
+                const js::time32_t from = random() % what_if.makespan(), to = from + 1 + random() % 99;
+                blocked[machine].emplace_back(from, to);
+                what_if.block_machine(machine, from, to);
+                name = "block_machine " + std::to_string(machine);
+                break;
+            }
+            default:
+                what_if.change_duration(job, operation, 1 + random() % 99);
+                name = "change_duration " + std::to_string(job) + " " + std::to_string(operation);
+        }
+
+        tasks.clear();
+        for (size_t other = 0; other < what_if.jobs(); other++)
+            for (size_t i = 0; what_if.contains(other) and i < machines_count; i++)
+                tasks.emplace_back(what_if.start(other, i), other, i);
+        std::sort(tasks.begin(), tasks.end());
+        const size_t none = tasks.size();
+        machine_prev.assign(what_if.jobs() * machines_count, none);
+        last.assign(machines_count, none);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            const auto [start, other, task] = tasks[i];
+            size_t& previous = last[what_if.machine(other, task)];
+            machine_prev[other * machines_count + task] = previous;
+            previous = i;
+        }
+        expected.assign(what_if.jobs() * machines_count, 0);
+        js::time32_t makespan = 0;
+        for (bool changed = true; changed;) {
+            changed = false;
+            makespan = 0;
+            for (const auto& [start, other, task] : tasks) {
+                const size_t node = other * machines_count + task;
+                js::time32_t ready = task == 0 ? 0 : expected[node - 1] + what_if.duration(other, task - 1);
+                if (machine_prev[node] != none) {
+                    const auto [previous_start, previous_job, previous_task] = tasks[machine_prev[node]];
+                    ready = std::max(ready, expected[previous_job * machines_count + previous_task]
+                                            + what_if.duration(previous_job, previous_task));
+                }
+                ready = available_start(what_if.machine(other, task), ready, what_if.duration(other, task));
+                changed |= ready != expected[node];
+                expected[node] = ready;
+                makespan = std::max(makespan, ready + what_if.duration(other, task));
+            }
+        }
+        for (const auto& [start, other, task] : tasks)
+            if (start != expected[other * machines_count + task] and failure.empty())
+                failure = "after " + name + ", task " + std::to_string(other) + " " + std::to_string(task)
+                          + " starts at " + std::to_string(start) + " instead of "
+                          + std::to_string(expected[other * machines_count + task]);
+        if (failure.empty() and makespan != what_if.makespan())
+            failure = "after " + name + ", makespan " + std::to_string(what_if.makespan()) + " instead of "
+                      + std::to_string(makespan);
+    }
+    return report(failure.empty(), "what-if: " + std::to_string(edits_count)
+                                   + " random edits match a propagation from scratch", failure);
+}
+
+/** The seeded random Giffler-Thompson engine must build the same valid schedule from every engine and every run. */
+int run_random_engine_test(const std::string& data_directory) {
+    js::instance data;
+    data.load_from_file(data_directory + js::path_sep + "ft10.txt");
+    js::thread_pool pool(0);
+    js::schedule first(data), second(data), again(data);
+    const auto engine = js::create_engine("active-random", data);
+    engine->run(first, pool, {});
+    engine->run(again, pool, {});
+    js::create_engine("active-random", data)->run(second, pool, {});
+    const auto& starts = first.solution().scheduled_times;
+    return report(js::validate(first).valid() and starts == second.solution().scheduled_times
+                  and starts == again.solution().scheduled_times,
+                  "active-random: the same schedule on every run, makespan "
+                      + std::to_string(first.longest_timeline()),
+                  js::validate(first).error);
+}
+
+/** Writes an instance or a solution record in the text format, for comparisons. */
+template<typename Data>
+std::string text_of(const Data& data) {
+    std::ostringstream text;
+    data.write(text);
+    return text.str();
+}
+
+void load_binary(js::instance& data, std::string_view bytes) {
+    data.load_binary_from_memory(bytes);
+}
+
+void load_binary(js::solution_record& record, std::string_view bytes) {
+    record.load_from_memory(bytes);
+}
+
+/** Converts an instance or a solution record to the binary format and back, returning its text before and after. */
+template<typename Data>
+std::pair<std::string, std::string> binary_round_trip(const Data& data) {
+    std::ostringstream binary;
+    data.write_binary(binary);
+    Data loaded;
+    load_binary(loaded, binary.str());
+    return {text_of(data), text_of(loaded)};
+}
+
+/** Whether a binary file cut one, four or half its bytes short is refused. */
+template<typename Data>
+bool rejects_truncated(const Data& data) {
+    std::ostringstream binary;
+    data.write_binary(binary);
+    const std::string bytes = binary.str();
+    for (const size_t cut : {size_t(1), size_t(4), bytes.size() / 2}) {
+        try {
+            Data loaded;
+            load_binary(loaded, std::string_view(bytes).substr(0, bytes.size() - cut));
+            return false;
+        } catch (const std::exception&) {}
+    }
+    return true;
+}
+
+/**
+ * Text to binary to text identity for every instance of the data directory and every solution the batch test wrote
+ * for it, plus a flexible instance with downtimes and its solution, which carry the sections version 2 adds; and
+ * rejection of truncated binary files.
+ */
+int run_binary_test(const std::string& data_directory, const std::string& output_directory) {
+    const std::string flexible_text = "3 3\n0 3 1 2 2 2\n0 2 2 1 1 4\n1 4 2 3 0 1\neligible\n0 0 2 1 2\n2 1 1 1\n"
+                                      "downtime\n0 4 6\n2 0 3\n";
+    js::instance flexible;
+    flexible.load_from_memory(flexible_text);
+    js::thread_pool pool(0);
+    js::solver solver(flexible, {});
+    const js::solution_record flexible_solution = solver.solve(pool).record();
+
+    std::vector<std::string> mismatches;
+    size_t checked = 0;
+    const auto check = [&](const auto& data, const std::string& name) {
+        const auto [before, after] = binary_round_trip(data);
+        if (before != after) mismatches.push_back(name);
+        checked++;
+    };
+    check(flexible, "flexible instance");
+    check(flexible_solution, "flexible solution");
+    for (const std::string& path : js::list_instances(data_directory)) {
+        js::instance data;
+        data.load_from_file(path);
+        check(data, path);
+        js::solution_record solution;
+        solution.load_from_file(output_directory + js::path_sep + js::extract_file_name(path));
+        check(solution, path + " solution");
+    }
+    std::string details;
+    for (const std::string& name : mismatches) details += (details.empty() ? "" : ", ") + name;
+    int failures = report(mismatches.empty() and not flexible_solution.machines.empty(),
+                          "binary: " + std::to_string(checked) + " instances and solutions survive a round trip",
+                          "changed: " + details);
+
+    js::instance classic;
+    classic.load_from_file(data_directory + js::path_sep + "ft06.txt");
+    js::schedule schedule(classic);
+    schedule.schedule_jobs<js::heuristics::pass>();
+    failures += report(rejects_truncated(classic) and rejects_truncated(flexible)
+                       and rejects_truncated(schedule.record()) and rejects_truncated(flexible_solution),
+                       "binary: truncated instances and solutions are rejected");
+    return failures == 0 ? 0 : 1;
+}
+
+/** Branch and bound must prove the known optima of ft06 and la01 to la05, starting from a list schedule. */
+int run_exact_test(const std::string& data_directory) {
+    const std::vector<std::pair<std::string, js::time32_t>> optima = {
+            {"ft06", 55}, {"la01", 666}, {"la02", 655}, {"la03", 597}, {"la04", 590}, {"la05", 593}};
+    js::thread_pool pool(0);
+    int failures = 0;
+    for (const auto& [name, optimum] : optima) {
+        js::instance data;
+        data.load_from_file(data_directory + js::path_sep + name + ".txt");
+        js::schedule schedule(data);
+        schedule.schedule_jobs<js::heuristics::pass>();
+        js::branch_and_bound exact(data);
+        const auto statistics = exact.run(pool, schedule.solution(), schedule.longest_timeline(),
+                                          js::compute_lower_bounds(data).value(), uint64_t(1) << 24, 60'000'000);
+        schedule.assign(exact.best_solution());
+        const js::validation validation = js::validate(schedule);
+        failures += report(statistics.complete and validation.valid() and schedule.longest_timeline() == optimum,
+                           "branch and bound: " + name + " solved to " + std::to_string(optimum) + " in "
+                               + std::to_string(statistics.nodes) + " nodes",
+                           "makespan " + std::to_string(schedule.longest_timeline()) + ", complete "
+                               + std::to_string(statistics.complete) + " " + validation.error);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+/** The flexible fixture must keep its eligible machines and downtimes, and its solved schedule must respect them. */
+int run_flexible_test(const std::string& data_directory) {
+    js::instance data;
+    data.load_from_file(data_directory + js::path_sep + "flex1.txt");
+    js::thread_pool pool(0);
+    js::solver solver(data, {});
+    const js::schedule& schedule = solver.solve(pool);
+    const js::validation validation = js::validate(schedule);
+    const auto& machines = schedule.solution().assigned_machines;
+    size_t moved = 0;
+    for (size_t i = 0; i < machines.size(); i++) moved += machines[i] != data.machines[i];
+    return report(data.flexible() and not data.downtimes.empty() and validation.valid()
+                  and machines.size() == data.tasks_count(),
+                  "flexible: flex1 solved to " + std::to_string(schedule.longest_timeline()) + " with "
+                      + std::to_string(moved) + " tasks on alternative machines",
+                  validation.error);
+}
+
+/**
+ * Solution cache: a hit returns the stored schedule whatever the budget of the run that stored it, a warm start never
+ * ends worse than its cached schedule, stores past the capacity evict the oldest entries and a corrupt entry is a miss.
+ */
+int run_cache_test(const std::string& data_directory, const std::string& output_directory) {
+    const std::string directory = output_directory + js::path_sep + "cache";
+    std::filesystem::remove_all(directory);
+    js::thread_pool pool(0);
+    js::instance data;
+    data.load_from_file(data_directory + js::path_sep + "ft10.txt");
+    const auto solve = [&](js::solution_cache& cache, uint64_t time_limit) {
+        js::solver_options options;
+        options.cache = &cache;
+        options.time_limit = time_limit;
+        js::solver solver(data, options);
+        const js::schedule& solution = solver.solve(pool);
+        return std::make_pair(solution.record(), js::validate(solution).valid());
+    };
+    int failures = 0;
+    {
+        js::solution_cache cache(directory, uintmax_t(1) << 20);
+        const auto [searched, searched_valid] = solve(cache, 100);
+        const auto [hit, hit_valid] = solve(cache, 0);
+        failures += report(searched_valid and hit_valid and hit.start_times == searched.start_times,
+                           "cache: a run without improvement returns the stored schedule",
+                           "stored makespan " + std::to_string(searched.makespan) + ", returned "
+                               + std::to_string(hit.makespan));
+        const auto [warm, warm_valid] = solve(cache, 100);
+        failures += report(warm_valid and warm.makespan <= searched.makespan,
+                           "cache: a warm start does not get worse",
+                           "cached makespan " + std::to_string(searched.makespan) + ", warm start "
+                               + std::to_string(warm.makespan));
+    }
+    {
+        for (const auto& file : std::filesystem::directory_iterator(directory))
+            std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) / 2);
+        js::solution_cache cache(directory, uintmax_t(1) << 20);
+        const auto [recovered, recovered_valid] = solve(cache, 0);
+        const auto [stored, stored_valid] = solve(cache, 0);
+        failures += report(recovered_valid and stored_valid and stored.start_times == recovered.start_times,
+                           "cache: a truncated entry is a miss and is replaced");
+    }
+    {
+        std::filesystem::remove_all(directory);
+        std::ostringstream entry;
+        const js::solution_record record = js::schedule(data).record();
+        record.write_binary(entry);
+        const uintmax_t capacity = 3 * entry.str().size() + entry.str().size() / 2;
+        js::solution_cache cache(directory, capacity);
+        const uint64_t entries = 10;
+        for (uint64_t key = 1; key <= entries; key++) cache.store(key, record);
+        uintmax_t total = 0;
+        for (const auto& file : std::filesystem::directory_iterator(directory)) total += file.file_size();
+        js::solution_record newest, oldest;
+        failures += report(total <= capacity and cache.lookup(entries, newest) and not cache.lookup(1, oldest),
+                           "cache: storing past the capacity evicts the least recently used entries",
+                           std::to_string(total) + " bytes stored, capacity " + std::to_string(capacity));
+    }
+    std::filesystem::remove_all(directory);
+    return failures == 0 ? 0 : 1;
 }
 
 int main(int argc, char** argv) {
 
-    if (argc < 4) {
+    if (argc < 3) {
         const std::string executable = js::extract_file_name(argv[0]);
         std::cout << "Perform automatic test on instances from a directory" << std::endl;
-        std::cout << "Usage: " << executable
-                  << " <solver_executable> <data_directory> <output_directory> [checker_executable]" << std::endl;
+        std::cout << "Usage: " << executable << " <data_directory> <output_directory>" << std::endl;
         return 1;
     }
-    run_test(argv[1], argc > 4 ? argv[4] : "", argv[2], argv[3]);
-}
\ No newline at end of file
+    int failures = run_test(argv[1], argv[2], js::thread_pool::default_threads_count());
+    failures += run_online_test(10, 20000);
+    failures += run_what_if_test(argv[1], 500);
+    failures += run_random_engine_test(argv[1]);
+    failures += run_exact_test(argv[1]);
+    failures += run_flexible_test(argv[1]);
+    failures += run_cache_test(argv[1], argv[2]);
+    failures += run_binary_test(argv[1], argv[2]);
+    return failures == 0 ? 0 : 1;
+}
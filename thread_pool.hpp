@@ -0,0 +1,161 @@
+#ifndef JOB_SHOP_THREAD_POOL
+#define JOB_SHOP_THREAD_POOL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace js {
+
+    /**
+     * Work-stealing thread pool. Every worker owns a deque: it takes tasks from the front of its own deque and,
+     * when that is empty, steals from the back of the others. Tasks submitted from outside are dealt round-robin,
+     * tasks submitted by a worker go to its own deque. A pool without workers runs tasks inline.
+     */
+    class thread_pool {
+
+        struct worker_queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<worker_queue>> queues;
+        std::mutex mutex;
+        std::condition_variable task_available, all_done;
+        std::atomic<size_t> next_queue = 0;
+        size_t queued = 0, pending = 0;
+        bool stopping = false;
+
+        inline static thread_local const thread_pool* current_pool = nullptr;
+        inline static thread_local size_t current_worker = 0;
+
+        bool try_pop(size_t self, std::function<void()>& task) {
+            for (size_t i = 0; i < queues.size(); i++) {
+                worker_queue& queue = *queues[(self + i) % queues.size()];
+                std::lock_guard lock(queue.mutex);
+                if (queue.tasks.empty()) continue;
+                if (i == 0) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                } else {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void work(size_t self) {
+            current_pool = this;
+            current_worker = self;
+            while (true) {
+                std::function<void()> task;
+                if (try_pop(self, task)) {
+                    {
+                        std::lock_guard lock(mutex);
+                        queued--;
+                    }
+                    task();
+                    std::lock_guard lock(mutex);
+                    if (--pending == 0) all_done.notify_all();
+                } else {
+                    std::unique_lock lock(mutex);
+                    task_available.wait(lock, [this] { return stopping or queued > 0; });
+                    if (stopping and queued == 0) return;
+                }
+            }
+        }
+
+    public:
+
+        explicit thread_pool(size_t threads_count = default_threads_count()) {
+            for (size_t i = 0; i < threads_count; i++) queues.push_back(std::make_unique<worker_queue>());
+            workers.reserve(threads_count);
+            for (size_t i = 0; i < threads_count; i++) workers.emplace_back(&thread_pool::work, this, i);
+        }
+
+        thread_pool(const thread_pool&) = delete;
+
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool() {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            task_available.notify_all();
+            for (auto& worker : workers) worker.join();
+        }
+
+        static size_t default_threads_count() {
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return workers.size();
+        }
+
+        /** Queues a task; a pool without workers runs it inline, without wrapping it in a function object. */
+        template<typename Task>
+        void submit(Task&& task) {
+            if (workers.empty()) return task();
+            const size_t target = current_pool == this ? current_worker : next_queue++ % queues.size();
+            {
+                std::lock_guard lock(mutex);
+                std::lock_guard queue_lock(queues[target]->mutex);
+                queues[target]->tasks.emplace_back(std::forward<Task>(task));
+                queued++;
+                pending++;
+            }
+            task_available.notify_one();
+        }
+
+        /**
+         * Runs <code>task(i)</code> for every i below count and returns when all have finished. The caller runs
+         * queued tasks while it waits, so a task running on the pool may call it without tying up its worker.
+         */
+        template<typename Task>
+        void parallel_for(size_t count, Task&& task) {
+            if (workers.empty() or count < 2) {
+                for (size_t i = 0; i < count; i++) task(i);
+                return;
+            }
+            std::atomic<size_t> remaining = count;
+            for (size_t i = 0; i < count; i++)
+                submit([&task, &remaining, i] {
+                    task(i);
+                    remaining.fetch_sub(1, std::memory_order_release);
+                });
+            const size_t self = current_pool == this ? current_worker : 0;
+            std::function<void()> other;
+            while (remaining.load(std::memory_order_acquire) > 0) {
+                if (not try_pop(self, other)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                {
+                    std::lock_guard lock(mutex);
+                    queued--;
+                }
+                other();
+                std::lock_guard lock(mutex);
+                if (--pending == 0) all_done.notify_all();
+            }
+        }
+
+        void wait() {
+            std::unique_lock lock(mutex);
+            all_done.wait(lock, [this] { return pending == 0; });
+        }
+    };
+}
+
+#endif //JOB_SHOP_THREAD_POOL
@@ -45,6 +45,11 @@ namespace js {
             return time.count();
         }
 
+        uint64_t get_elapsed_time() const {
+            Dur time = std::chrono::duration_cast<Dur>((running ? now() : end_point) - start_point);
+            return time.count();
+        }
+
         std::string unit() {
             constexpr intmax_t denominator = Dur::period::den;
             if (denominator == 1) return "s";
@@ -0,0 +1,150 @@
+#ifndef JOB_SHOP_VALIDATOR
+#define JOB_SHOP_VALIDATOR
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "dataset.hpp"
+#include "heuristics.hpp"
+#include "schedule.hpp"
+
+namespace js {
+
+    struct validation {
+
+        std::string error;
+        time32_t makespan = 0;
+
+        [[nodiscard]] bool valid() const {
+            return error.empty();
+        }
+
+        explicit operator bool() const {
+            return valid();
+        }
+    };
+
+    /**
+     * Checks the start times of a solution in linear time: precedence within every job, no overlap of tasks on a
+     * machine (tasks of each machine are radix-sorted by start time) nor with its downtimes and the reported
+     * makespan. In a flexible instance every task must also run on one of its eligible machines.
+     */
+    validation validate(const instance& data, const solution_state& solution, time32_t reported_makespan) {
+        validation result;
+        const auto& start = solution.scheduled_times;
+        if (start.size() != data.tasks_count()) {
+            result.error = "expected " + std::to_string(data.tasks_count()) + " start times, got "
+                           + std::to_string(start.size());
+            return result;
+        }
+        if (data.flexible() and solution.assigned_machines.size() != data.tasks_count()) {
+            result.error = "expected " + std::to_string(data.tasks_count()) + " task machines, got "
+                           + std::to_string(solution.assigned_machines.size());
+            return result;
+        }
+
+        std::vector<size_t> offsets(data.machines_count + 1);
+        for (size_t job = 0; job < data.jobs_count; job++) {
+            time32_t job_end = 0;
+            for (size_t i = 0; i < data.machines_count; i++) {
+                const size_t index = data.index(job, i);
+                if (start[index] < job_end and result.valid())
+                    result.error = "job " + std::to_string(job) + " operation " + std::to_string(i) + " starts at "
+                                   + std::to_string(start[index]) + " before its predecessor ends at "
+                                   + std::to_string(job_end);
+                job_end = start[index] + data.durations[index];
+                const id32_t machine = solution.machine(data, index);
+                const auto eligible = data.eligible_machines(index);
+                if (std::find(eligible.begin(), eligible.end(), machine) == eligible.end()) {
+                    result.error = "job " + std::to_string(job) + " operation " + std::to_string(i)
+                                   + " cannot run on machine " + std::to_string(machine);
+                    return result;
+                }
+                offsets[machine + 1]++;
+            }
+            result.makespan = std::max(result.makespan, job_end);
+        }
+        if (not result.valid()) return result;
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<id32_t> order(data.tasks_count()), scratch;
+        std::vector<uint32_t> keys(start.begin(), start.end());
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t index = 0; index < data.tasks_count(); index++)
+            order[cursor[solution.machine(data, index)]++] = id32_t(index);
+        std::vector<downtime> downtimes(data.downtimes);
+        std::sort(downtimes.begin(), downtimes.end(), [](const downtime& a, const downtime& b) {
+            return a.machine != b.machine ? a.machine < b.machine : a.start < b.start;
+        });
+        auto down = downtimes.begin();
+        for (size_t machine = 0; machine < data.machines_count; machine++) {
+            std::vector<id32_t> tasks(order.begin() + std::ptrdiff_t(offsets[machine]),
+                                      order.begin() + std::ptrdiff_t(offsets[machine + 1]));
+            sort_by_key(tasks, keys, scratch);
+            id32_t previous = -1;
+            for (const id32_t task : tasks) {
+                if (data.durations[task] == 0) continue;
+                if (previous != -1 and start[previous] + data.durations[previous] > start[task]) {
+                    result.error = "tasks of jobs " + std::to_string(previous / data.machines_count) + " and "
+                                   + std::to_string(task / data.machines_count) + " overlap on machine "
+                                   + std::to_string(machine) + " at time " + std::to_string(start[task]);
+                    return result;
+                }
+                while (down != downtimes.end() and size_t(down->machine) == machine and down->end <= start[task])
+                    ++down;
+                if (down != downtimes.end() and size_t(down->machine) == machine
+                    and down->start < start[task] + data.durations[task]) {
+                    result.error = "task of job " + std::to_string(task / data.machines_count) + " on machine "
+                                   + std::to_string(machine) + " at time " + std::to_string(start[task])
+                                   + " overlaps its downtime from " + std::to_string(down->start);
+                    return result;
+                }
+                previous = task;
+            }
+            while (down != downtimes.end() and size_t(down->machine) == machine) ++down;
+        }
+
+        if (reported_makespan != result.makespan)
+            result.error = "reported makespan " + std::to_string(reported_makespan) + " differs from the actual "
+                           + std::to_string(result.makespan);
+        return result;
+    }
+
+    /**
+     * Validates a schedule: its start times as above, and its machine timelines, which must hold exactly the tasks
+     * of the instance with their durations.
+     */
+    validation validate(const schedule& schedule) {
+        const instance& data = schedule.problem();
+        validation result = validate(data, schedule.solution(), schedule.longest_timeline());
+        if (not result) return result;
+
+        std::vector<size_t> expected(data.machines_count * data.jobs_count);
+        for (size_t index = 0; index < data.tasks_count(); index++) {
+            const size_t job = index / data.machines_count;
+            expected[schedule.solution().machine(data, index) * data.jobs_count + job] += data.durations[index];
+        }
+        const auto& timelines = schedule.timelines();
+        for (size_t machine = 0; machine < timelines.size(); machine++) {
+            for (const auto& task : timelines[machine].occupied()) {
+                size_t& remaining = expected[machine * data.jobs_count + task.task_job_id];
+                if (remaining < task.length()) {
+                    result.error = "machine " + std::to_string(machine) + " holds job "
+                                   + std::to_string(task.task_job_id) + " for longer than the instance requires";
+                    return result;
+                }
+                remaining -= task.length();
+            }
+        }
+        const auto missing = std::find_if(expected.begin(), expected.end(), [](size_t left) { return left > 0; });
+        if (missing != expected.end()) {
+            const size_t position = missing - expected.begin();
+            result.error = "machine " + std::to_string(position / data.jobs_count) + " holds job "
+                           + std::to_string(position % data.jobs_count) + " for less time than the instance requires";
+        }
+        return result;
+    }
+}
+
+#endif //JOB_SHOP_VALIDATOR